@@ -0,0 +1,267 @@
+// Microbenchmarks for the individual pipeline kernels.
+//
+//   clirasterizer_microbench --benchmark_filter=DrawTriangle
+//
+// All inputs are synthetic and generated from fixed seeds, so results are
+// comparable across builds and machines.
+
+#include <benchmark/benchmark.h>
+
+#include <array>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "framebuffer.h"
+#include "texture.h"
+#include "mesh.h"
+#include "rasterizer.h"
+#include "terminal_renderer.h"
+
+namespace {
+
+// ============================================================================
+// Synthetic inputs
+// ============================================================================
+
+Texture make_texture(int size) {
+    std::vector<uint8_t> rgba(static_cast<size_t>(size) * size * 4);
+    std::mt19937 rng(1);
+    for (auto& b : rgba) b = static_cast<uint8_t>(rng());
+    for (size_t i = 3; i < rgba.size(); i += 4) rgba[i] = 255;
+    Texture tex;
+    tex.set_pixels(size, size, std::move(rgba), false);
+    return tex;
+}
+
+enum TriangleShape { TINY, LARGE, SLIVER };
+
+struct TriangleBatch {
+    std::vector<std::array<HMM_Vec4, 3>> clip_verts;
+    std::array<HMM_Vec2, 3> texcoords = {HMM_V2(0, 0), HMM_V2(1, 0), HMM_V2(0, 1)};
+    std::array<HMM_Vec3, 3> normals = {HMM_V3(0, 0, 1), HMM_V3(0, 0, 1), HMM_V3(0, 0, 1)};
+};
+
+// Front-facing triangles in NDC (W = 1) for a given size distribution:
+// TINY covers ~1-4 pixels, LARGE a quarter of the screen, SLIVER is long and thin
+TriangleBatch make_triangles(TriangleShape shape, int count, int fb_width, int fb_height) {
+    TriangleBatch batch;
+    std::mt19937 rng(42);
+    std::uniform_real_distribution<float> pos(-0.9f, 0.9f);
+    std::uniform_real_distribution<float> depth(-0.9f, 0.9f);
+    float px = 2.0f / fb_width;   // One pixel in NDC
+    float py = 2.0f / fb_height;
+
+    for (int i = 0; i < count; i++) {
+        float cx = pos(rng), cy = pos(rng), z = depth(rng);
+        float dx = 0, dy = 0;
+        switch (shape) {
+            case TINY:   dx = 2.0f * px;  dy = 2.0f * py; break;
+            case LARGE:  dx = 0.5f;       dy = 0.5f;      break;
+            case SLIVER: dx = 1.5f;       dy = 1.0f * py; break;
+        }
+        // Counter-clockwise in NDC so the triangles survive backface culling
+        batch.clip_verts.push_back({
+            HMM_V4(cx - dx, cy - dy, z, 1.0f),
+            HMM_V4(cx + dx, cy - dy, z, 1.0f),
+            HMM_V4(cx, cy + dy, z, 1.0f),
+        });
+    }
+    return batch;
+}
+
+void fill_random(Framebuffer& fb, uint32_t seed) {
+    std::mt19937 rng(seed);
+    for (auto& c : fb.color_buffer) {
+        uint32_t v = rng();
+        c = Color(v & 0xFF, (v >> 8) & 0xFF, (v >> 16) & 0xFF);
+    }
+}
+
+// Grid of `n` x `n` quads written as OBJ text with positions, texcoords and normals
+std::string write_grid_obj(int n) {
+    std::filesystem::path path = std::filesystem::temp_directory_path() /
+                                 ("clirasterizer_bench_grid_" + std::to_string(n) + ".obj");
+    if (std::filesystem::exists(path)) return path.string();
+
+    std::ofstream out(path);
+    for (int y = 0; y <= n; y++) {
+        for (int x = 0; x <= n; x++) {
+            out << "v " << x << " 0 " << y << "\n";
+            out << "vt " << static_cast<float>(x) / n << " " << static_cast<float>(y) / n << "\n";
+        }
+    }
+    out << "vn 0 1 0\n";
+    for (int y = 0; y < n; y++) {
+        for (int x = 0; x < n; x++) {
+            int a = y * (n + 1) + x + 1;
+            int b = a + 1, c = a + n + 2, d = a + n + 1;
+            out << "f " << a << "/" << a << "/1 " << b << "/" << b << "/1 "
+                << c << "/" << c << "/1 " << d << "/" << d << "/1\n";
+        }
+    }
+    return path.string();
+}
+
+// ============================================================================
+// Texture::sample
+// ============================================================================
+
+// Arg(0): coherent UVs stepping across neighbouring texels, Arg(1): random UVs
+void BM_TextureSample(benchmark::State& state) {
+    static const Texture tex = make_texture(2048);
+    std::vector<HMM_Vec2> uvs(4096);
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> dist(-1.0f, 2.0f);
+    for (size_t i = 0; i < uvs.size(); i++) {
+        uvs[i] = state.range(0) ? HMM_V2(dist(rng), dist(rng))
+                                : HMM_V2(0.25f + i / 8192.0f * 0.01f, 0.5f);
+    }
+
+    for (auto _ : state) {
+        uint32_t sum = 0;
+        for (const auto& uv : uvs) sum += tex.sample(uv.X, uv.Y).r;
+        benchmark::DoNotOptimize(sum);
+    }
+    state.SetItemsProcessed(state.iterations() * uvs.size());
+}
+BENCHMARK(BM_TextureSample)->ArgName("random")->Arg(0)->Arg(1);
+
+// ============================================================================
+// Rasterizer::draw_triangle
+// ============================================================================
+
+void BM_DrawTriangle(benchmark::State& state) {
+    constexpr int WIDTH = 320, HEIGHT = 180, BATCH = 256;
+    static const Texture tex = make_texture(256);
+    Framebuffer fb(WIDTH, HEIGHT);
+    Rasterizer rasterizer(fb);
+    rasterizer.set_texture(&tex);
+    TriangleBatch batch = make_triangles(static_cast<TriangleShape>(state.range(0)), BATCH, WIDTH, HEIGHT);
+
+    for (auto _ : state) {
+        for (const auto& tri : batch.clip_verts) {
+            rasterizer.draw_triangle(tri, batch.texcoords, batch.normals);
+        }
+        // Reset depth so every batch does the same work
+        state.PauseTiming();
+        rasterizer.shade();
+        fb.clear();
+        state.ResumeTiming();
+    }
+    state.SetItemsProcessed(state.iterations() * BATCH);
+}
+BENCHMARK(BM_DrawTriangle)->ArgName("shape")->Arg(TINY)->Arg(LARGE)->Arg(SLIVER);
+
+// Lighting pass over a fully covered framebuffer
+void BM_Shade(benchmark::State& state) {
+    constexpr int WIDTH = 320, HEIGHT = 180;
+    Framebuffer fb(WIDTH, HEIGHT);
+    Rasterizer rasterizer(fb);
+    std::array<HMM_Vec2, 3> uv = {HMM_V2(0, 0), HMM_V2(1, 0), HMM_V2(0, 1)};
+    std::array<HMM_Vec3, 3> n = {HMM_V3(0, 0, 1), HMM_V3(0, 0, 1), HMM_V3(0, 0, 1)};
+
+    for (auto _ : state) {
+        state.PauseTiming();
+        fb.clear();
+        rasterizer.draw_triangle({HMM_V4(-1, -1, 0, 1), HMM_V4(3, -1, 0, 1), HMM_V4(-1, 3, 0, 1)}, uv, n);
+        state.ResumeTiming();
+        rasterizer.shade();
+    }
+    state.SetItemsProcessed(state.iterations() * WIDTH * HEIGHT);
+}
+BENCHMARK(BM_Shade)->UseRealTime();
+
+// ============================================================================
+// Framebuffer::clear / set_pixel
+// ============================================================================
+
+void BM_FramebufferClear(benchmark::State& state) {
+    Framebuffer fb(static_cast<int>(state.range(0)), static_cast<int>(state.range(1)));
+    for (auto _ : state) {
+        fb.clear();
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * fb.width * fb.height * (sizeof(Color) + sizeof(uint32_t)));
+}
+BENCHMARK(BM_FramebufferClear)->Args({120, 60})->Args({320, 180})->Args({1920, 1080})->UseRealTime();
+
+// Threads hammer either the same 8x8 block (Arg 1: contended CAS) or
+// disjoint rows (Arg 0). Depth decreases so most writes win the depth test.
+void BM_SetPixel(benchmark::State& state) {
+    constexpr int WIDTH = 256, HEIGHT = 256;
+    static Framebuffer fb(WIDTH, HEIGHT);
+    const bool contended = state.range(0) != 0;
+    const int thread = state.thread_index();
+
+    float depth = 1.0f;
+    int i = 0;
+    for (auto _ : state) {
+        int x = i & 7;
+        int y = contended ? ((i >> 3) & 7) : (thread * 8 + ((i >> 3) & 7)) % HEIGHT;
+        fb.set_pixel(x, y, Color(255, 0, 0), depth);
+        depth -= 1e-7f;
+        if (depth < -1.0f) depth = 1.0f;
+        i++;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SetPixel)->ArgName("contended")->Arg(0)->Arg(1)->ThreadRange(1, 8)->UseRealTime();
+
+// ============================================================================
+// TerminalRenderer::encode
+// ============================================================================
+
+// random 0: flat background, 1: random pixels (worst case, no repeated colors)
+// backend: TerminalBackend (0 blocks, 1 sixel, 2 kitty, 3 quadrant, 4 sextant)
+// colors: ColorMode of the text backends (0 truecolor, 1 xterm-256, 2 16 colors)
+void BM_TerminalEncode(benchmark::State& state) {
+    Framebuffer fb(160, 90);
+    if (state.range(0)) fill_random(fb, 3);
+    std::string output;
+    TerminalRenderer terminal(static_cast<TerminalBackend>(state.range(1)));
+    terminal.colors = static_cast<ColorMode>(state.range(2));
+
+    for (auto _ : state) {
+        terminal.encode(fb, output);
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetBytesProcessed(state.iterations() * output.size());
+    state.counters["bytes_per_frame"] = static_cast<double>(output.size());
+}
+BENCHMARK(BM_TerminalEncode)->ArgNames({"random", "backend", "colors"})->ArgsProduct({{0, 1}, {0, 1, 2, 3, 4}, {0}});
+BENCHMARK(BM_TerminalEncode)->ArgNames({"random", "backend", "colors"})->ArgsProduct({{0, 1}, {0, 4}, {1, 2}});
+
+// ============================================================================
+// Mesh::load_obj
+// ============================================================================
+
+void BM_LoadObj(benchmark::State& state) {
+    std::string path = write_grid_obj(static_cast<int>(state.range(0)));
+    auto file_size = std::filesystem::file_size(path);
+
+    // Silence the loader's progress output
+    std::ostringstream sink;
+    std::streambuf* saved = std::cout.rdbuf(sink.rdbuf());
+    for (auto _ : state) {
+        Mesh mesh;
+        if (!mesh.load_obj(path.c_str())) {
+            state.SkipWithError("failed to load generated OBJ");
+            break;
+        }
+        benchmark::DoNotOptimize(mesh.vertices.data());
+        sink.str("");
+    }
+    std::cout.rdbuf(saved);
+    state.SetBytesProcessed(state.iterations() * file_size);
+}
+BENCHMARK(BM_LoadObj)->ArgName("grid")->Arg(64)->Arg(256)->Unit(benchmark::kMillisecond);
+
+}  // namespace
+
+BENCHMARK_MAIN();
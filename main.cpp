@@ -8,675 +8,952 @@
 #include <limits>
 #include <chrono>
 #include <cstring>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <sstream>
+#include <atomic>
+#include <memory>
 
-#ifdef _WIN32
-#define NOMINMAX  // Prevent windows.h from defining min/max macros
-#include <conio.h>
-#include <windows.h>
-#else
-#include <unistd.h>
-#include <termios.h>
-#include <fcntl.h>
-#endif
+#include "platform.h"
+#include "framebuffer.h"
+#include "texture.h"
+#include "mesh.h"
+#include "rasterizer.h"
+#include "scene.h"
+#include "gltf_loader.h"
+#include "terminal_renderer.h"
+#include "camera.h"
+#include "trace.h"
+#include "render_server.h"
+#include "scene_cache.h"
+#include "temporal.h"
+#include "resolution_scaler.h"
+#include "tty_recording.h"
+#include "frame_capture.h"
 
-#define TINYOBJ_LOADER_C_IMPLEMENTATION
-#include "tinyobj_loader_c.h"
+// ============================================================================
+// Configuration
+// ============================================================================
 
-#define STB_IMAGE_IMPLEMENTATION
-#include "stb_image.h"
+// Default fallback resolution
+constexpr int DEFAULT_WIDTH = 120;
+constexpr int DEFAULT_HEIGHT = 30;
 
-#define STB_IMAGE_WRITE_IMPLEMENTATION
-#include "stb_image_write.h"
+// Reserve rows for status display at bottom: a gap, the status line, the key
+// help and, last, the message line (screenshots, traces)
+constexpr int STATUS_ROWS = 4;
 
-#include "HandmadeMath.h"
-#include "parallel-util.hpp"
-#include <atomic>
-#include <memory>
+// Extra status rows used by the profiler overlay, above the message line
+constexpr int PROFILER_ROWS = 2;
+
+// Compact human-readable count: 950, 12.3k, 4.5M, 1.2G
+inline std::string format_count(uint64_t n) {
+    char buf[32];
+    if (n >= 1000000000ull) snprintf(buf, sizeof(buf), "%.1fG", n / 1e9);
+    else if (n >= 1000000ull) snprintf(buf, sizeof(buf), "%.1fM", n / 1e6);
+    else if (n >= 10000ull) snprintf(buf, sizeof(buf), "%.1fk", n / 1e3);
+    else snprintf(buf, sizeof(buf), "%llu", static_cast<unsigned long long>(n));
+    return buf;
+}
 
 // ============================================================================
-// Platform-specific keyboard input
+// Viewport layouts - several cameras composited into one terminal frame
 // ============================================================================
 
-#ifdef _WIN32
-// Windows: use _kbhit() and _getch() from conio.h
-inline bool keyboard_hit() { return _kbhit() != 0; }
-inline int get_char() { return _getch(); }
-
-// Windows: Get terminal window size (columns, rows)
-inline void get_terminal_size(int& width, int& height) {
-    CONSOLE_SCREEN_BUFFER_INFO csbi;
-    HANDLE hOut = GetStdHandle(STD_OUTPUT_HANDLE);
-    if (GetConsoleScreenBufferInfo(hOut, &csbi)) {
-        width = csbi.srWindow.Right - csbi.srWindow.Left + 1;
-        height = csbi.srWindow.Bottom - csbi.srWindow.Top + 1;
-    } else {
-        width = 120;   // Default fallback
-        height = 30;
+enum class ViewLayout { SINGLE, SPLIT, TRIPLE, COUNT };
+
+inline const char* layout_name(ViewLayout layout) {
+    switch (layout) {
+        case ViewLayout::SPLIT:  return "player | overview";
+        case ViewLayout::TRIPLE: return "player | overview + minimap";
+        default:                 return "player";
     }
 }
-#else
-// Unix/Linux: implement non-blocking keyboard input
-inline bool keyboard_hit() {
-    struct termios oldt, newt;
-    int ch;
-    int oldf;
-    
-    tcgetattr(STDIN_FILENO, &oldt);
-    newt = oldt;
-    newt.c_lflag &= ~(ICANON | ECHO);
-    tcsetattr(STDIN_FILENO, TCSANOW, &newt);
-    oldf = fcntl(STDIN_FILENO, F_GETFL, 0);
-    fcntl(STDIN_FILENO, F_SETFL, oldf | O_NONBLOCK);
-    
-    ch = getchar();
-    
-    tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
-    fcntl(STDIN_FILENO, F_SETFL, oldf);
-    
-    if (ch != EOF) {
-        ungetc(ch, stdin);
-        return true;
-    }
-    return false;
+
+// Camera high above the scene looking straight down; the mesh is normalized
+// to about [-1, 1], so height 3 frames all of it
+inline Camera overhead_camera(float x, float z, float height) {
+    Camera c;
+    c.position = HMM_V3(x, height, z);
+    c.pitch = -1.55f;   // Not exactly -90 degrees, LookAt needs a non-parallel up vector
+    return c;
 }
-inline int get_char() { return getchar(); }
-
-// Unix/Linux: Get terminal window size (columns, rows)
-#include <sys/ioctl.h>
-inline void get_terminal_size(int& width, int& height) {
-    struct winsize ws;
-    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0) {
-        width = ws.ws_col;
-        height = ws.ws_row;
-    } else {
-        width = 120;   // Default fallback
-        height = 30;
+
+// Split a `width` x `height` pixel framebuffer into disjoint viewports.
+// Horizontal splits fall on even rows so each view starts on a character
+// cell; a one-pixel gap of background color separates views.
+inline std::vector<Viewport> layout_viewports(ViewLayout layout, int width, int height,
+                                              const Camera& player, const HMM_Mat4& model) {
+    auto make = [&](int x, int y, int w, int h, const Camera& camera) {
+        Viewport vp;
+        vp.x = x;
+        vp.y = y;
+        vp.width = std::max(1, w);
+        vp.height = std::max(1, h);
+        vp.model_view = HMM_MulM4(camera.get_view_matrix(), model);
+        vp.mvp = HMM_MulM4(make_projection(vp.width, vp.height), vp.model_view);
+        return vp;
+    };
+
+    Camera overview = overhead_camera(0.0f, 0.0f, 3.0f);
+    Camera minimap = overhead_camera(player.position.X, player.position.Z, player.position.Y + 1.0f);
+    int side = width / 3;
+    int main_width = width - side - 1;
+
+    switch (layout) {
+        case ViewLayout::SPLIT:
+            if (width < 3) break;
+            return {make(0, 0, width / 2, height, player),
+                    make(width / 2 + 1, 0, width - width / 2 - 1, height, overview)};
+        case ViewLayout::TRIPLE: {
+            if (width < 3 || height < 4) break;
+            int top = (height / 2) & ~1;
+            return {make(0, 0, main_width, height, player),
+                    make(main_width + 1, 0, side, top - 2, overview),
+                    make(main_width + 1, top, side, height - top, minimap)};
+        }
+        default:
+            break;
     }
+    return {make(0, 0, width, height, player)};
 }
-#endif
 
 // ============================================================================
-// Configuration
+// Offline rendering - headless image-sequence output (no tty required)
 // ============================================================================
 
-// Default fallback resolution
-constexpr int DEFAULT_WIDTH = 120;
-constexpr int DEFAULT_HEIGHT = 30;
+struct OfflineOptions {
+    enum class Format { PNG, RAW };
 
-// Reserve rows for status display at bottom
-constexpr int STATUS_ROWS = 3;
+    int width = 640;
+    int height = 360;
+    const char* poses_path = nullptr;   // Camera path file, default camera if null
+    const char* out_pattern = nullptr;  // Pattern with one %d for the frame index (valid_frame_pattern)
+    Format format = Format::PNG;
+    int interpolate = 0;                // Extra frames generated between consecutive poses
+    int encode_threads = 0;             // 0 = derive from hardware concurrency
+    int png_bands = 0;                  // Row bands compressed in parallel per PNG, 0 = auto
+};
 
-// ============================================================================
-// Color structure (with alpha channel support)
-// ============================================================================
+// True if `pattern` is safe to pass to printf with one int: exactly one
+// %d (with an optional zero-padded width such as %05d) and otherwise only %%
+inline bool valid_frame_pattern(const char* pattern) {
+    int conversions = 0;
+    for (const char* p = pattern; *p; p++) {
+        if (*p != '%') continue;
+        p++;
+        if (*p == '%') continue;
+        while (*p >= '0' && *p <= '9') p++;
+        if (*p != 'd') return false;
+        conversions++;
+    }
+    return conversions == 1;
+}
 
-struct Color {
-    uint8_t r, g, b, a;
-    
-    Color() : r(0), g(0), b(0), a(255) {}
-    Color(uint8_t r, uint8_t g, uint8_t b) : r(r), g(g), b(b), a(255) {}
-    Color(uint8_t r, uint8_t g, uint8_t b, uint8_t a) : r(r), g(g), b(b), a(a) {}
-    
-    Color operator*(float f) const {
-        return Color(
-            static_cast<uint8_t>(std::clamp(r * f, 0.0f, 255.0f)),
-            static_cast<uint8_t>(std::clamp(g * f, 0.0f, 255.0f)),
-            static_cast<uint8_t>(std::clamp(b * f, 0.0f, 255.0f)),
-            a  // Alpha unchanged by lighting
-        );
+// Load camera poses, one per line: "x y z yaw_deg pitch_deg" ('#' starts a comment)
+inline bool load_camera_path(const char* filename, std::vector<Camera>& poses) {
+    FILE* f = fopen(filename, "r");
+    if (!f) {
+        std::cerr << "Failed to open camera path: " << filename << std::endl;
+        return false;
     }
-    
-    Color operator+(const Color& other) const {
-        return Color(
-            static_cast<uint8_t>(std::clamp(r + other.r, 0, 255)),
-            static_cast<uint8_t>(std::clamp(g + other.g, 0, 255)),
-            static_cast<uint8_t>(std::clamp(b + other.b, 0, 255)),
-            static_cast<uint8_t>(std::clamp(a + other.a, 0, 255))
-        );
+
+    char line[256];
+    int line_number = 0;
+    while (fgets(line, sizeof(line), f)) {
+        line_number++;
+        if (char* comment = strchr(line, '#')) *comment = '\0';
+
+        Camera cam;
+        float yaw_deg = 0.0f, pitch_deg = 0.0f;
+        int n = sscanf(line, "%f %f %f %f %f", &cam.position.X, &cam.position.Y, &cam.position.Z,
+                       &yaw_deg, &pitch_deg);
+        if (n <= 0) continue;  // Blank or comment-only line
+        if (n < 3) {
+            std::cerr << filename << ":" << line_number << ": expected \"x y z [yaw] [pitch]\"" << std::endl;
+            fclose(f);
+            return false;
+        }
+        cam.yaw = HMM_AngleDeg(yaw_deg);
+        cam.rotate_pitch(HMM_AngleDeg(pitch_deg));
+        poses.push_back(cam);
     }
-    
-    // Check if pixel should be clipped (alpha test)
-    bool should_clip(float threshold = 0.1f) const {
-        return (a / 255.0f) < threshold;
+    fclose(f);
+
+    if (poses.empty()) {
+        std::cerr << "Camera path has no poses: " << filename << std::endl;
+        return false;
     }
-};
+    return true;
+}
 
-// ============================================================================
-// Framebuffer - stores color and depth for each pixel (thread-safe)
-// ============================================================================
+// Insert `steps` linearly interpolated poses between each pair of consecutive poses
+inline std::vector<Camera> interpolate_camera_path(const std::vector<Camera>& poses, int steps) {
+    if (steps <= 0 || poses.size() < 2) return poses;
 
-// Helper: convert float to uint32 for atomic comparison (preserves order)
-inline uint32_t float_to_uint32(float f) {
-    uint32_t u;
-    std::memcpy(&u, &f, sizeof(u));
-    // Handle sign bit to preserve ordering: flip all bits for negative, flip sign bit for positive
-    if (u & 0x80000000) {
-        return ~u;  // Negative: flip all bits
-    } else {
-        return u ^ 0x80000000;  // Positive: flip sign bit
+    std::vector<Camera> path;
+    path.reserve((poses.size() - 1) * (steps + 1) + 1);
+    for (size_t i = 0; i + 1 < poses.size(); i++) {
+        const Camera& a = poses[i];
+        const Camera& b = poses[i + 1];
+        for (int s = 0; s <= steps; s++) {
+            float t = static_cast<float>(s) / (steps + 1);
+            Camera cam;
+            cam.position = HMM_LerpV3(a.position, t, b.position);
+            cam.yaw = a.yaw + (b.yaw - a.yaw) * t;
+            cam.pitch = a.pitch + (b.pitch - a.pitch) * t;
+            path.push_back(cam);
+        }
     }
+    path.push_back(poses.back());
+    return path;
 }
 
-class Framebuffer {
+// Encodes and writes finished frames on background threads while the caller
+// renders the next ones. The queue is bounded so memory stays flat on long runs.
+class FrameWriter {
 public:
-    int width, height;
-    std::vector<Color> color_buffer;
-    std::unique_ptr<std::atomic<uint32_t>[]> depth_buffer;  // Atomic array for thread-safe depth test
-    
-    Framebuffer(int w, int h) : width(w), height(h) {
-        color_buffer.resize(w * h);
-        depth_buffer = std::make_unique<std::atomic<uint32_t>[]>(w * h);
-        clear();
+    FrameWriter(OfflineOptions::Format format, int num_threads, int png_bands, size_t max_queued)
+        : format(format), png_bands(png_bands), max_queued(max_queued) {
+        for (int i = 0; i < num_threads; i++) {
+            workers.emplace_back([this, i] {
+                // Trace lanes above the parallel_for workers
+                std::string name = "frame writer " + std::to_string(i);
+                TraceLane lane(worker_count() + 1 + i, name.c_str());
+                worker_loop();
+            });
+        }
     }
-    
-    void clear() {
-        Color bg_color(20, 20, 30);
-        uint32_t max_depth = float_to_uint32(std::numeric_limits<float>::max());
-        
-        // Parallel clear for better performance
-        parallelutil::parallel_for(width * height, [&](int i) {
-            color_buffer[i] = bg_color;
-            depth_buffer[i].store(max_depth, std::memory_order_relaxed);
-        });
+
+    ~FrameWriter() { finish(); }
+
+    // Queue a frame for writing; blocks while the queue is full
+    void submit(std::string filename, int width, int height, std::vector<uint8_t> rgb) {
+        std::unique_lock<std::mutex> lock(mutex);
+        space_available.wait(lock, [this] { return queue.size() < max_queued; });
+        queue.push_back({std::move(filename), width, height, std::move(rgb)});
+        work_available.notify_one();
     }
-    
-    // Thread-safe pixel write with atomic depth test
-    void set_pixel(int x, int y, const Color& color, float depth) {
-        if (x < 0 || x >= width || y < 0 || y >= height) return;
-        int idx = y * width + x;
-        
-        uint32_t new_depth = float_to_uint32(depth);
-        uint32_t old_depth = depth_buffer[idx].load(std::memory_order_relaxed);
-        
-        // Atomic compare-and-swap loop for depth test
-        while (new_depth < old_depth) {
-            if (depth_buffer[idx].compare_exchange_weak(old_depth, new_depth,
-                    std::memory_order_relaxed, std::memory_order_relaxed)) {
-                color_buffer[idx] = color;  // Won the race, write color
-                break;
-            }
-            // CAS failed, old_depth updated, retry if still closer
+
+    // Flush all queued frames and join the worker threads
+    void finish() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done = true;
+        }
+        work_available.notify_all();
+        for (auto& t : workers) {
+            if (t.joinable()) t.join();
         }
     }
-    
-    Color get_pixel(int x, int y) const {
-        if (x < 0 || x >= width || y < 0 || y >= height) return Color();
-        return color_buffer[y * width + x];
-    }
-    
-    // Save framebuffer to PNG file for debugging
-    bool save_to_file(const char* filename) const {
-        std::vector<uint8_t> pixels(width * height * 3);
-        for (int i = 0; i < width * height; i++) {
-            pixels[i * 3 + 0] = color_buffer[i].r;
-            pixels[i * 3 + 1] = color_buffer[i].g;
-            pixels[i * 3 + 2] = color_buffer[i].b;
+
+    int failures() const { return failed.load(); }
+
+private:
+    struct Job {
+        std::string filename;
+        int width, height;
+        std::vector<uint8_t> rgb;
+    };
+
+    void worker_loop() {
+        while (true) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                work_available.wait(lock, [this] { return done || !queue.empty(); });
+                if (queue.empty()) return;
+                job = std::move(queue.front());
+                queue.pop_front();
+            }
+            space_available.notify_one();
+
+            TRACE_SCOPE("write frame");
+            if (!write(job)) {
+                failed++;
+                std::cerr << "Failed to write frame: " << job.filename << std::endl;
+            }
         }
-        int result = stbi_write_png(filename, width, height, 3, pixels.data(), width * 3);
-        return result != 0;
     }
-    
-    // Resize framebuffer to new dimensions
-    void resize(int new_width, int new_height) {
-        if (new_width == width && new_height == height) return;
-        width = new_width;
-        height = new_height;
-        color_buffer.resize(width * height);
-        depth_buffer = std::make_unique<std::atomic<uint32_t>[]>(width * height);
-        clear();
+
+    bool write(const Job& job) const {
+        if (format == OfflineOptions::Format::PNG) {
+            return write_png(job.filename.c_str(), job.width, job.height, job.rgb.data(), png_bands);
+        }
+        FILE* f = fopen(job.filename.c_str(), "wb");
+        if (!f) return false;
+        bool ok = fwrite(job.rgb.data(), 1, job.rgb.size(), f) == job.rgb.size();
+        return (fclose(f) == 0) && ok;
     }
+
+    OfflineOptions::Format format;
+    int png_bands;
+    size_t max_queued;
+    std::vector<std::thread> workers;
+    std::deque<Job> queue;
+    std::mutex mutex;
+    std::condition_variable work_available;
+    std::condition_variable space_available;
+    std::atomic<int> failed{0};
+    bool done = false;
 };
 
-// ============================================================================
-// Texture - loads and samples image textures (with alpha channel support)
-// ============================================================================
+// Render every pose of the camera path to an image file
+inline int run_offline(const Scene& scene, const Texture& texture, const OfflineOptions& options) {
+    std::vector<Camera> poses;
+    if (options.poses_path) {
+        if (!load_camera_path(options.poses_path, poses)) return 1;
+    } else {
+        poses.push_back(Camera());
+    }
+    poses = interpolate_camera_path(poses, options.interpolate);
 
-class Texture {
-public:
-    int width = 0, height = 0, channels = 0;
-    std::vector<uint8_t> data;
-    bool loaded = false;
-    bool has_alpha = false;
-    
-    bool load(const char* filename) {
-        // Load with 4 channels (RGBA) to support alpha
-        uint8_t* img_data = stbi_load(filename, &width, &height, &channels, 4);
-        if (!img_data) {
-            std::cerr << "Failed to load texture: " << filename << std::endl;
-            return false;
-        }
-        has_alpha = (channels == 4);
-        data.assign(img_data, img_data + width * height * 4);
-        stbi_image_free(img_data);
-        loaded = true;
-        std::cout << "Loaded texture: " << width << "x" << height 
-                  << " (alpha: " << (has_alpha ? "yes" : "no") << ")" << std::endl;
-        return true;
+    const char* pattern = options.out_pattern;
+    if (!pattern) {
+        pattern = (options.format == OfflineOptions::Format::PNG) ? "frame_%05d.png" : "frame_%05d.rgb";
     }
-    
-    Color sample(float u, float v) const {
-        if (!loaded) return Color(200, 200, 200, 255);
-        
-        // Wrap UV coordinates
-        u = u - std::floor(u);
-        v = v - std::floor(v);
-        
-        int x = static_cast<int>(u * (width - 1));
-        int y = static_cast<int>((1.0f - v) * (height - 1));  // Flip V
-        
-        x = std::clamp(x, 0, width - 1);
-        y = std::clamp(y, 0, height - 1);
-        
-        int idx = (y * width + x) * 4;
-        return Color(data[idx], data[idx + 1], data[idx + 2], data[idx + 3]);
+
+    // Rendering already saturates all cores, so the encoders get a share of them
+    int encode_threads = options.encode_threads;
+    if (encode_threads <= 0) {
+        encode_threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) / 2);
     }
-};
+    // Each encoder splits its PNGs into bands so the encoders together can
+    // use every core when rendering is the faster side
+    int png_bands = options.png_bands;
+    if (png_bands <= 0) {
+        png_bands = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) / encode_threads);
+    }
+
+    HMM_Vec3 mesh_center;
+    float mesh_scale;
+    scene.get_bounds(mesh_center, mesh_scale);
+    HMM_Mat4 model = make_model_matrix(mesh_center, mesh_scale);
+    HMM_Mat4 projection = make_projection(options.width, options.height);
+
+    Framebuffer fb(options.width, options.height);
+    Rasterizer rasterizer(fb);
+    rasterizer.set_texture(&texture);
+
+    auto start_time = std::chrono::high_resolution_clock::now();
+    int frames_written = 0;
+    {
+        FrameWriter writer(options.format, encode_threads, png_bands, encode_threads * 2);
+        for (size_t i = 0; i < poses.size(); i++) {
+            TRACE_SCOPE("frame");
+            {
+                TRACE_SCOPE("clear");
+                fb.clear();
+            }
+            Viewport view = {0, 0, fb.width, fb.height, HMM_M4D(1.0f), HMM_MulM4(poses[i].get_view_matrix(), model)};
+            view.mvp = HMM_MulM4(projection, view.model_view);
+            rasterizer.draw_items(scene.draw_list(), {&view, 1});
+
+            TRACE_SCOPE("submit");
+            std::vector<uint8_t> rgb;
+            fb.copy_rgb(rgb);
+            char filename[1024];
+            snprintf(filename, sizeof(filename), pattern, static_cast<int>(i));
+            writer.submit(filename, fb.width, fb.height, std::move(rgb));
+        }
+        writer.finish();
+        frames_written = static_cast<int>(poses.size()) - writer.failures();
+    }
+    float seconds = std::chrono::duration<float>(std::chrono::high_resolution_clock::now() - start_time).count();
+
+    std::cout << "Rendered " << frames_written << "/" << poses.size() << " frames at "
+              << options.width << "x" << options.height << " in " << std::fixed << std::setprecision(2)
+              << seconds << "s (" << (frames_written / std::max(seconds, 1e-6f)) << " frames/s)" << std::endl;
+    return frames_written == static_cast<int>(poses.size()) ? 0 : 1;
+}
 
 // ============================================================================
-// Vertex structure for rendering
+// Benchmark mode - deterministic flythrough with per-stage timing as JSON
 // ============================================================================
 
-struct Vertex {
-    HMM_Vec3 position;
-    HMM_Vec2 texcoord;
-    HMM_Vec3 normal;
+struct BenchOptions {
+    int frames = 120;
+    int warmup = 5;                    // Untimed frames rendered before measuring
+    const char* json_path = nullptr;   // JSON report destination, stdout if null
+    const char* sink_path = nullptr;   // Where encoded terminal frames are written
+    bool reproject = false;            // Reuse the previous frame (see temporal.h)
+    int reproject_refresh = 30;
+    TerminalBackend output = TerminalBackend::BLOCKS;
+    ColorMode colors = ColorMode::TRUECOLOR;
+    bool dither = false;
 };
 
-// ============================================================================
-// Mesh - stores geometry data
-// ============================================================================
+// Fixed camera path for frame `i` of `n`: one orbit around the normalized mesh
+// while moving in and out, always looking at the center. Depends only on
+// (i, n), so every run and every build renders the same views.
+inline Camera bench_camera(int i, int n) {
+    float t = static_cast<float>(i) / std::max(1, n);
+    float angle = t * 2.0f * HMM_PI32;
+    float radius = 1.8f + 0.9f * std::cos(angle * 2.0f);
+    float height = 0.6f + 0.4f * std::sin(angle * 3.0f);
 
-class Mesh {
-public:
-    std::vector<Vertex> vertices;
-    std::vector<unsigned int> indices;
-    
-    bool load_obj(const char* filename) {
-        tinyobj_attrib_t attrib;
-        tinyobj_shape_t* shapes = nullptr;
-        size_t num_shapes = 0;
-        tinyobj_material_t* materials = nullptr;
-        size_t num_materials = 0;
-        
-        // File reading callback
-        auto file_reader = [](void* ctx, const char* filename, int is_mtl,
-                              const char* obj_filename, char** buf, size_t* len) {
-            (void)ctx;
-            (void)is_mtl;
-            (void)obj_filename;
-            
-            FILE* f = fopen(filename, "rb");
-            if (!f) {
-                *buf = nullptr;
-                *len = 0;
-                return;
-            }
-            
-            fseek(f, 0, SEEK_END);
-            *len = ftell(f);
-            fseek(f, 0, SEEK_SET);
-            
-            *buf = (char*)malloc(*len + 1);
-            fread(*buf, 1, *len, f);
-            (*buf)[*len] = '\0';
-            fclose(f);
+    Camera cam;
+    cam.position = HMM_V3(radius * std::sin(angle), height, radius * std::cos(angle));
+    HMM_Vec3 dir = HMM_NormV3(HMM_MulV3F(cam.position, -1.0f));
+    cam.yaw = std::atan2(-dir.X, -dir.Z);
+    cam.rotate_pitch(std::asin(dir.Y));
+    return cam;
+}
+
+// Summary statistics of one timing series, in milliseconds
+struct SampleStats {
+    double mean = 0, p50 = 0, p90 = 0, p99 = 0, min = 0, max = 0;
+
+    static SampleStats compute(std::vector<double> samples) {
+        SampleStats s;
+        if (samples.empty()) return s;
+        std::sort(samples.begin(), samples.end());
+        auto percentile = [&](double p) {
+            size_t rank = static_cast<size_t>(std::ceil(p * samples.size()));
+            return samples[std::clamp<size_t>(rank, 1, samples.size()) - 1];
         };
-        
-        int result = tinyobj_parse_obj(&attrib, &shapes, &num_shapes,
-                                       &materials, &num_materials,
-                                       filename, file_reader, nullptr,
-                                       TINYOBJ_FLAG_TRIANGULATE);
-        
-        if (result != TINYOBJ_SUCCESS) {
-            std::cerr << "Failed to load OBJ: " << filename << std::endl;
-            return false;
-        }
-        
-        // Convert to our vertex format
-        vertices.clear();
-        indices.clear();
-        
-        for (size_t i = 0; i < attrib.num_faces; i++) {
-            tinyobj_vertex_index_t idx = attrib.faces[i];
-            
-            Vertex v;
-            
-            // Position
-            v.position.X = attrib.vertices[3 * idx.v_idx + 0];
-            v.position.Y = attrib.vertices[3 * idx.v_idx + 1];
-            v.position.Z = attrib.vertices[3 * idx.v_idx + 2];
-            
-            // Texcoord
-            if (idx.vt_idx >= 0 && attrib.num_texcoords > 0) {
-                v.texcoord.X = attrib.texcoords[2 * idx.vt_idx + 0];
-                v.texcoord.Y = attrib.texcoords[2 * idx.vt_idx + 1];
-            } else {
-                v.texcoord = HMM_V2(0, 0);
-            }
-            
-            // Normal
-            if (idx.vn_idx >= 0 && attrib.num_normals > 0) {
-                v.normal.X = attrib.normals[3 * idx.vn_idx + 0];
-                v.normal.Y = attrib.normals[3 * idx.vn_idx + 1];
-                v.normal.Z = attrib.normals[3 * idx.vn_idx + 2];
-            } else {
-                v.normal = HMM_V3(0, 1, 0);
-            }
-            
-            vertices.push_back(v);
-            indices.push_back(static_cast<unsigned int>(vertices.size() - 1));
-        }
-        
-        // Clean up
-        tinyobj_attrib_free(&attrib);
-        tinyobj_shapes_free(shapes, num_shapes);
-        tinyobj_materials_free(materials, num_materials);
-        
-        std::cout << "Loaded mesh with " << vertices.size() << " vertices" << std::endl;
-        return true;
-    }
-    
-    // Calculate bounding box and return center and scale
-    void get_bounds(HMM_Vec3& center, float& scale) const {
-        HMM_Vec3 min_bound = HMM_V3(std::numeric_limits<float>::max(),
-                                     std::numeric_limits<float>::max(),
-                                     std::numeric_limits<float>::max());
-        HMM_Vec3 max_bound = HMM_V3(std::numeric_limits<float>::lowest(),
-                                     std::numeric_limits<float>::lowest(),
-                                     std::numeric_limits<float>::lowest());
-        
-        for (const auto& v : vertices) {
-            min_bound.X = std::min(min_bound.X, v.position.X);
-            min_bound.Y = std::min(min_bound.Y, v.position.Y);
-            min_bound.Z = std::min(min_bound.Z, v.position.Z);
-            max_bound.X = std::max(max_bound.X, v.position.X);
-            max_bound.Y = std::max(max_bound.Y, v.position.Y);
-            max_bound.Z = std::max(max_bound.Z, v.position.Z);
-        }
-        
-        center = HMM_MulV3F(HMM_AddV3(min_bound, max_bound), 0.5f);
-        float dx = max_bound.X - min_bound.X;
-        float dy = max_bound.Y - min_bound.Y;
-        float dz = max_bound.Z - min_bound.Z;
-        scale = std::max({dx, dy, dz});
+        for (double v : samples) s.mean += v;
+        s.mean /= samples.size();
+        s.p50 = percentile(0.50);
+        s.p90 = percentile(0.90);
+        s.p99 = percentile(0.99);
+        s.min = samples.front();
+        s.max = samples.back();
+        return s;
     }
 };
 
-// ============================================================================
-// Rasterizer - software triangle rasterization
-// ============================================================================
-
-class Rasterizer {
-public:
-    Framebuffer& fb;
-    const Texture* texture = nullptr;
-    HMM_Vec3 light_dir;
-    
-    Rasterizer(Framebuffer& framebuffer) : fb(framebuffer) {
-        light_dir = HMM_NormV3(HMM_V3(0.5f, 1.0f, 0.8f));
+inline std::string json_escape(const std::string& s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        if (static_cast<unsigned char>(c) < 0x20) continue;
+        out += c;
     }
-    
-    void set_texture(const Texture* tex) {
-        texture = tex;
+    return out;
+}
+
+inline int run_bench(const Scene& scene, const Texture& texture, const char* mesh_path,
+                     int width, int height, const BenchOptions& options) {
+#ifdef _WIN32
+    const char* null_device = "NUL";
+#else
+    const char* null_device = "/dev/null";
+#endif
+    const char* sink_path = options.sink_path ? options.sink_path : null_device;
+    FILE* sink = fopen(sink_path, "wb");
+    if (!sink) {
+        std::cerr << "Failed to open benchmark output: " << sink_path << std::endl;
+        return 1;
     }
-    
-    // Draw a triangle with interpolated attributes
-    // Includes frustum culling and backface culling for performance
-    void draw_triangle(
-        const std::array<HMM_Vec4, 3>& clip_verts,
-        const std::array<HMM_Vec2, 3>& texcoords,
-        const std::array<HMM_Vec3, 3>& normals
-    ) {
-        // ================================================================
-        // Frustum Culling in Clip Space (before perspective divide)
-        // ================================================================
-        
-        // Near plane culling: check if any vertex is behind camera
-        for (int i = 0; i < 3; i++) {
-            if (clip_verts[i].W <= 0.001f) return;  // Vertex behind camera
-        }
-        
-        // Frustum plane culling: check if all vertices are outside the same plane
-        // A vertex is outside if: coord > W (right/top/far) or coord < -W (left/bottom/near)
-        int all_left = 0, all_right = 0, all_bottom = 0, all_top = 0, all_near = 0, all_far = 0;
-        
-        for (int i = 0; i < 3; i++) {
-            float x = clip_verts[i].X;
-            float y = clip_verts[i].Y;
-            float z = clip_verts[i].Z;
-            float w = clip_verts[i].W;
-            
-            if (x < -w) all_left++;
-            if (x >  w) all_right++;
-            if (y < -w) all_bottom++;
-            if (y >  w) all_top++;
-            if (z < -w) all_near++;
-            if (z >  w) all_far++;
-        }
-        
-        // If all 3 vertices are outside the same frustum plane, cull the triangle
-        if (all_left == 3 || all_right == 3 || 
-            all_bottom == 3 || all_top == 3 ||
-            all_near == 3 || all_far == 3) {
-            return;
-        }
-        
-        // ================================================================
-        // Perspective Divide - Convert to Screen Space
-        // ================================================================
-        
-        std::array<HMM_Vec3, 3> screen_verts;
-        for (int i = 0; i < 3; i++) {
-            float w = clip_verts[i].W;
-            float inv_w = 1.0f / w;
-            
-            float x = clip_verts[i].X * inv_w;
-            float y = clip_verts[i].Y * inv_w;
-            float z = clip_verts[i].Z * inv_w;
-            
-            // NDC to screen space
-            screen_verts[i].X = (x + 1.0f) * 0.5f * fb.width;
-            screen_verts[i].Y = (1.0f - y) * 0.5f * fb.height;  // Flip Y
-            screen_verts[i].Z = z;
+
+    HMM_Vec3 mesh_center;
+    float mesh_scale;
+    scene.get_bounds(mesh_center, mesh_scale);
+    HMM_Mat4 model = make_model_matrix(mesh_center, mesh_scale);
+    HMM_Mat4 projection = make_projection(width, height);
+
+    Framebuffer fb(width, height);
+    Rasterizer rasterizer(fb);
+    rasterizer.set_texture(&texture);
+    TemporalReprojector reprojector;
+    reprojector.refresh_interval = options.reproject_refresh;
+    int64_t tiles_reused = 0, tiles_total = 0;
+    std::string encoded;
+    TerminalRenderer terminal(options.output);
+    terminal.colors = options.colors;
+    terminal.dither = options.dither;
+
+    const char* stage_names[] = {"clear", "vertex", "setup", "raster", "shade", "encode", "write", "frame"};
+    constexpr int NUM_SERIES = 8;
+    std::vector<double> series[NUM_SERIES];
+    int64_t visible_triangles = 0;
+    int64_t encoded_bytes = 0;
+    PipelineCounters counter_totals;
+
+    for (int i = -options.warmup; i < options.frames; i++) {
+        TRACE_SCOPE("frame");
+        FrameTimings t;
+        Camera cam = bench_camera(std::max(i, 0), options.frames);
+        Viewport view = {0, 0, width, height, HMM_M4D(1.0f), HMM_MulM4(cam.get_view_matrix(), model)};
+        view.mvp = HMM_MulM4(projection, view.model_view);
+        const HMM_Mat4& mvp = view.mvp;
+
+        // With reprojection the clear stage also reprojects the previous frame
+        auto stage_start = std::chrono::high_resolution_clock::now();
+        if (options.reproject) {
+            reprojector.begin_frame(fb, rasterizer, mvp);
+        } else {
+            TRACE_SCOPE("clear");
+            fb.clear();
         }
-        
-        // ================================================================
-        // Screen Space Culling
-        // ================================================================
-        
-        // Compute bounding box
-        float min_x = std::min({screen_verts[0].X, screen_verts[1].X, screen_verts[2].X});
-        float max_x = std::max({screen_verts[0].X, screen_verts[1].X, screen_verts[2].X});
-        float min_y = std::min({screen_verts[0].Y, screen_verts[1].Y, screen_verts[2].Y});
-        float max_y = std::max({screen_verts[0].Y, screen_verts[1].Y, screen_verts[2].Y});
-        
-        // Screen bounds culling - triangle completely outside screen
-        if (max_x < 0 || min_x >= fb.width || max_y < 0 || min_y >= fb.height) {
-            return;
+        t.clear = elapsed_ms(stage_start);
+
+        rasterizer.draw_items(scene.draw_list(), {&view, 1}, &t);
+        if (options.reproject) reprojector.end_frame(fb, mvp);
+
+        stage_start = std::chrono::high_resolution_clock::now();
+        {
+            TRACE_SCOPE("encode");
+            terminal.encode(fb, encoded);
         }
-        
-        int x0 = std::max(0, static_cast<int>(std::floor(min_x)));
-        int x1 = std::min(fb.width - 1, static_cast<int>(std::ceil(max_x)));
-        int y0 = std::max(0, static_cast<int>(std::floor(min_y)));
-        int y1 = std::min(fb.height - 1, static_cast<int>(std::ceil(max_y)));
-        
-        // Sub-pixel triangle culling
-        if (x0 > x1 || y0 > y1) return;
-        
-        // ================================================================
-        // Area and Backface Culling
-        // ================================================================
-        
-        // Edge function for barycentric coordinates
-        auto edge = [](const HMM_Vec3& a, const HMM_Vec3& b, float px, float py) {
-            return (px - a.X) * (b.Y - a.Y) - (py - a.Y) * (b.X - a.X);
-        };
-        
-        float area = edge(screen_verts[0], screen_verts[1], screen_verts[2].X, screen_verts[2].Y);
-        
-        // Degenerate triangle culling (zero area)
-        if (std::abs(area) < 0.001f) return;
-        
-        // Backface culling: positive area = clockwise winding = back face
-        // (In screen space with Y flipped, CCW triangles have negative area)
-        if (area < 0) return;
-        
-        // Rasterize
-        for (int y = y0; y <= y1; y++) {
-            for (int x = x0; x <= x1; x++) {
-                float px = x + 0.5f;
-                float py = y + 0.5f;
-                
-                float w0 = edge(screen_verts[1], screen_verts[2], px, py);
-                float w1 = edge(screen_verts[2], screen_verts[0], px, py);
-                float w2 = edge(screen_verts[0], screen_verts[1], px, py);
-                
-                // Check if inside triangle (allow for both winding orders)
-                bool inside = (w0 >= 0 && w1 >= 0 && w2 >= 0) || (w0 <= 0 && w1 <= 0 && w2 <= 0);
-                if (!inside) continue;
-                
-                // Barycentric coordinates
-                float inv_area = 1.0f / area;
-                w0 *= inv_area;
-                w1 *= inv_area;
-                w2 *= inv_area;
-                
-                // Interpolate depth
-                float depth = w0 * screen_verts[0].Z + w1 * screen_verts[1].Z + w2 * screen_verts[2].Z;
-                
-                // Depth test
-                if (depth < -1.0f || depth > 1.0f) continue;
-                
-                // Perspective-correct interpolation
-                float inv_w0 = 1.0f / clip_verts[0].W;
-                float inv_w1 = 1.0f / clip_verts[1].W;
-                float inv_w2 = 1.0f / clip_verts[2].W;
-                float inv_w = w0 * inv_w0 + w1 * inv_w1 + w2 * inv_w2;
-                float corr = 1.0f / inv_w;
-                
-                // Interpolate texcoords
-                HMM_Vec2 uv;
-                uv.X = (w0 * texcoords[0].X * inv_w0 + w1 * texcoords[1].X * inv_w1 + w2 * texcoords[2].X * inv_w2) * corr;
-                uv.Y = (w0 * texcoords[0].Y * inv_w0 + w1 * texcoords[1].Y * inv_w1 + w2 * texcoords[2].Y * inv_w2) * corr;
-                
-                // Interpolate normal
-                HMM_Vec3 normal;
-                normal.X = (w0 * normals[0].X * inv_w0 + w1 * normals[1].X * inv_w1 + w2 * normals[2].X * inv_w2) * corr;
-                normal.Y = (w0 * normals[0].Y * inv_w0 + w1 * normals[1].Y * inv_w1 + w2 * normals[2].Y * inv_w2) * corr;
-                normal.Z = (w0 * normals[0].Z * inv_w0 + w1 * normals[1].Z * inv_w1 + w2 * normals[2].Z * inv_w2) * corr;
-                normal = HMM_NormV3(normal);
-                
-                // Sample texture
-                Color base_color = texture ? texture->sample(uv.X, uv.Y) : Color(200, 200, 200, 255);
-                
-                // Alpha clip: skip pixels with alpha < 0.1 (alpha test)
-                if (base_color.should_clip(0.1f)) continue;
-                
-                // Simple diffuse lighting
-                float ndotl = std::max(0.0f, HMM_DotV3(normal, light_dir));
-                float ambient = 0.3f;
-                float diffuse = 0.7f * ndotl;
-                float lighting = ambient + diffuse;
-                
-                Color final_color = base_color * lighting;
-                fb.set_pixel(x, y, final_color, depth);
-            }
+        t.encode = elapsed_ms(stage_start);
+
+        stage_start = std::chrono::high_resolution_clock::now();
+        {
+            TRACE_SCOPE("write");
+            fwrite(encoded.data(), 1, encoded.size(), sink);
+            fflush(sink);
         }
+        t.write = elapsed_ms(stage_start);
+
+        if (i < 0) continue;
+        double values[NUM_SERIES] = {t.clear, t.vertex, t.setup, t.raster, t.shade, t.encode, t.write, t.total()};
+        for (int s = 0; s < NUM_SERIES; s++) series[s].push_back(values[s]);
+        visible_triangles += t.triangles_visible;
+        encoded_bytes += static_cast<int64_t>(encoded.size());
+        tiles_reused += reprojector.tiles_reused;
+        tiles_total += reprojector.tiles_total;
+        PipelineCounters frame_counters = rasterizer.counters;
+        frame_counters.terminal_bytes = encoded.size();
+        counter_totals.add(frame_counters);
     }
-};
+    fclose(sink);
 
-// ============================================================================
-// Terminal output - renders framebuffer to terminal using half-block characters
-// ============================================================================
+    double total_seconds = 0;
+    for (double v : series[NUM_SERIES - 1]) total_seconds += v / 1000.0;
+    total_seconds = std::max(total_seconds, 1e-9);
+    int frames = std::max(options.frames, 1);
+    int64_t triangles = static_cast<int64_t>(scene.triangle_count());
 
-class TerminalRenderer {
-public:
-    // Render framebuffer to terminal using "▀" character
-    // Foreground color = top pixel, Background color = bottom pixel
-    static void render(const Framebuffer& fb) {
-        std::string output;
-        output.reserve(fb.width * (fb.height / 2) * 40);  // Pre-allocate
-        
-        // Move cursor to top-left
-        output += "\033[H";
-        
-        // Process two rows at a time
-        for (int y = 0; y < fb.height; y += 2) {
-            for (int x = 0; x < fb.width; x++) {
-                Color top = fb.get_pixel(x, y);
-                Color bottom = (y + 1 < fb.height) ? fb.get_pixel(x, y + 1) : Color(0, 0, 0);
-                
-                // Set foreground (top pixel) and background (bottom pixel) colors
-                // Using 24-bit true color ANSI escape sequences
-                char buf[64];
-                snprintf(buf, sizeof(buf), "\033[38;2;%d;%d;%dm\033[48;2;%d;%d;%dm",
-                         top.r, top.g, top.b, bottom.r, bottom.g, bottom.b);
-                output += buf;
-                output += "\xE2\x96\x80";  // UTF-8 encoding of "▀" (U+2580)
-            }
-            output += "\033[0m\n";  // Reset colors and newline
-        }
-        
-        std::cout << output << std::flush;
+    std::ostringstream json;
+    json << std::fixed << std::setprecision(4);
+    json << "{\n"
+         << "  \"mesh\": \"" << json_escape(mesh_path) << "\",\n"
+         << "  \"vertices\": " << scene.vertex_count() << ",\n"
+         << "  \"instances\": " << scene.instance_count() << ",\n"
+         << "  \"triangles\": " << triangles << ",\n"
+         << "  \"width\": " << width << ",\n"
+         << "  \"height\": " << height << ",\n"
+         << "  \"frames\": " << options.frames << ",\n"
+         << "  \"warmup\": " << options.warmup << ",\n"
+         << "  \"threads\": " << worker_count() << ",\n"
+         << "  \"reproject\": " << (options.reproject ? "true" : "false") << ",\n"
+         << "  \"output\": \"" << backend_name(options.output) << "\",\n"
+         << "  \"colors\": \"" << color_mode_name(options.colors) << "\",\n"
+         << "  \"stages_ms\": {\n";
+    for (int s = 0; s < NUM_SERIES; s++) {
+        SampleStats st = SampleStats::compute(series[s]);
+        json << "    \"" << stage_names[s] << "\": {"
+             << "\"mean\": " << st.mean << ", \"p50\": " << st.p50 << ", \"p90\": " << st.p90
+             << ", \"p99\": " << st.p99 << ", \"min\": " << st.min << ", \"max\": " << st.max << "}"
+             << (s + 1 < NUM_SERIES ? ",\n" : "\n");
     }
-    
-    // Clear screen and hide cursor
-    static void init() {
-#ifdef _WIN32
-        // Set console to UTF-8 code page
-        SetConsoleOutputCP(CP_UTF8);
-        SetConsoleCP(CP_UTF8);
-        
-        // Enable virtual terminal processing for ANSI escape sequences
-        HANDLE hOut = GetStdHandle(STD_OUTPUT_HANDLE);
-        DWORD dwMode = 0;
-        GetConsoleMode(hOut, &dwMode);
-        dwMode |= ENABLE_VIRTUAL_TERMINAL_PROCESSING;
-        SetConsoleMode(hOut, dwMode);
-#endif
-        std::cout << "\033[2J";     // Clear screen
-        std::cout << "\033[?25l";   // Hide cursor
-        std::cout << std::flush;
+    json << "  },\n"
+         << "  \"throughput\": {\n"
+         << "    \"frames_per_sec\": " << options.frames / total_seconds << ",\n"
+         << "    \"triangles_per_sec\": " << triangles * options.frames / total_seconds << ",\n"
+         << "    \"visible_triangles_per_sec\": " << visible_triangles / total_seconds << ",\n"
+         << "    \"pixels_per_sec\": " << static_cast<double>(width) * height * options.frames / total_seconds << ",\n"
+         << "    \"encoded_bytes_per_frame\": " << static_cast<double>(encoded_bytes) / frames << ",\n"
+         << "    \"tiles_reused_fraction\": " << (tiles_total ? static_cast<double>(tiles_reused) / tiles_total : 0.0) << "\n"
+         << "  },\n";
+
+    // Hot-path counters averaged per frame
+    const PipelineCounters& c = counter_totals;
+    std::pair<const char*, uint64_t> counter_fields[] = {
+        {"instances_culled", c.instances_culled},
+        {"triangles_submitted", c.triangles_submitted},
+        {"triangles_visible", c.culled[CULL_NONE]},
+        {"culled_near", c.culled[CULL_NEAR]},
+        {"culled_frustum", c.culled[CULL_FRUSTUM]},
+        {"culled_offscreen", c.culled[CULL_OFFSCREEN]},
+        {"culled_subpixel", c.culled[CULL_SUBPIXEL]},
+        {"culled_degenerate", c.culled[CULL_DEGENERATE]},
+        {"culled_backface", c.culled[CULL_BACKFACE]},
+        {"culled_reused", c.culled[CULL_REUSED]},
+        {"pixels_tested", c.pixels_tested},
+        {"pixels_covered", c.pixels_covered},
+        {"pixels_alpha_clipped", c.pixels_alpha_clipped},
+        {"pixels_depth_failed", c.pixels_depth_failed},
+        {"pixels_shaded", c.pixels_shaded},
+        {"cas_retries", c.cas_retries},
+        {"terminal_bytes", c.terminal_bytes},
+    };
+    json << "  \"counters_per_frame\": {\n";
+    for (size_t i = 0; i < std::size(counter_fields); i++) {
+        json << "    \"" << counter_fields[i].first << "\": " << static_cast<double>(counter_fields[i].second) / frames
+             << (i + 1 < std::size(counter_fields) ? ",\n" : "\n");
     }
-    
-    // Show cursor and reset
-    static void cleanup() {
-        std::cout << "\033[?25h";   // Show cursor
-        std::cout << "\033[0m";     // Reset colors
-        std::cout << std::flush;
+    json << "  }\n"
+         << "}\n";
+
+    if (options.json_path) {
+        FILE* f = fopen(options.json_path, "w");
+        if (!f) {
+            std::cerr << "Failed to write benchmark report: " << options.json_path << std::endl;
+            return 1;
+        }
+        fputs(json.str().c_str(), f);
+        fclose(f);
+    } else {
+        std::cout << json.str() << std::flush;
     }
-};
+    return 0;
+}
 
 // ============================================================================
 // Main application
 // ============================================================================
 
+inline void print_usage(const char* program) {
+    std::cerr << "Usage: " << program << " [mesh.obj|scene.gltf|scene.glb] [texture.png] [options]\n"
+              << "\n"
+              << "  --scene FILE         Load meshes and their instances from a scene file instead\n"
+              << "                       (\"mesh NAME FILE.obj [TEXTURE.png]\" and\n"
+              << "                       \"instance NAME X Y Z [YAW_DEG] [SCALE]\" lines), a directory\n"
+              << "                       of OBJ files, or a glTF 2.0 .gltf/.glb file\n"
+              << "\n"
+              << "Headless rendering:\n"
+              << "  --headless           Render without a terminal and write image files\n"
+              << "  --size WxH           Output resolution (default 640x360)\n"
+              << "  --poses FILE         Camera path, one \"x y z yaw_deg pitch_deg\" per line\n"
+              << "  --interpolate N      Frames inserted between consecutive poses\n"
+              << "  --out PATTERN        Output filename pattern with one %d for the frame number\n"
+              << "                       (default frame_%05d.png)\n"
+              << "  --format png|raw     Output format; raw is packed 8-bit RGB\n"
+              << "  --encode-threads N   Background encoder threads\n"
+              << "  --png-bands N        Row bands compressed in parallel per PNG\n"
+              << "\n"
+              << "Benchmark:\n"
+              << "  --bench              Render a fixed flythrough headless and print JSON timings\n"
+              << "  --bench-frames N     Measured frames (default 120)\n"
+              << "  --bench-warmup N     Untimed frames before measuring (default 5)\n"
+              << "  --bench-json FILE    Write the JSON report to FILE instead of stdout\n"
+              << "  --bench-sink FILE    Destination of encoded terminal frames (default null device)\n"
+              << "\n"
+              << "  --reproject          Reuse the previous frame where the view barely changed and\n"
+              << "                       rasterize only invalidated tiles (interactive and --bench)\n"
+              << "  --reproject-refresh N  Force a full render every N frames (default 30)\n"
+              << "  --target-fps N       Lower the render resolution while frames miss this rate,\n"
+              << "                       back to full resolution when the camera stops (interactive)\n"
+              << "  --min-scale F        Lowest resolution scale for --target-fps (default 0.25)\n"
+              << "\n"
+              << "Terminal output:\n"
+              << "  --output MODE        auto|blocks|quadrant|sextant|sixel|kitty (default auto: ask\n"
+              << "                       the terminal; --bench encodes with blocks unless set)\n"
+              << "                       quadrant and sextant draw 2x2 and 2x3 pixels per cell\n"
+              << "  --colors MODE        truecolor|256|16: color escapes of the text modes (default\n"
+              << "                       truecolor); 256 and 16 use the xterm palette\n"
+              << "  --dither             Ordered dithering for --colors 256 and 16\n"
+              << "  --bandwidth RATE     Hold text output to RATE bytes/s (suffix k or M): send only\n"
+              << "                       changed cells, largest error first, with coarser colors\n"
+              << "                       while the budget is short (interactive)\n"
+              << "  --kitty-transfer M   zlib|shm: compressed inline data, or shared memory for\n"
+              << "                       terminals on the same machine (default zlib)\n"
+              << "\n"
+              << "Terminal recording:\n"
+              << "  --record FILE        Record the bytes sent to the terminal, per frame with\n"
+              << "                       timestamps (interactive)\n"
+              << "  --replay FILE        Write a recording to this terminal and report throughput\n"
+              << "  --replay-speed X     Replay pace relative to the recording (default 1; 0 sends\n"
+              << "                       frames back to back to measure the terminal)\n"
+              << "\n"
+              << "Video capture (interactive):\n"
+              << "  --capture DEST       Stream rendered frames to a file, or to a command with\n"
+              << "                       \"|cmd\" (e.g. \"|ffmpeg -i - out.mp4\")\n"
+              << "  --capture-format F   y4m|raw: YUV4MPEG2 4:4:4 or packed RGB24 (default y4m)\n"
+              << "  --capture-fps N      Frame rate of the captured stream (default 30)\n"
+              << "\n"
+              << "Scene sharing:\n"
+              << "  --scene-cache FILE   Map the decoded scene from FILE, creating it on first use;\n"
+              << "                       processes using the same FILE share one copy in memory\n"
+              << "                       (single OBJ mesh only; ignored with --scene and glTF)\n"
+              << "\n"
+              << "Render server (Unix only):\n"
+              << "  --serve SOCKET       Load the scene once and serve viewers on a Unix socket\n"
+              << "  --connect SOCKET     View a scene served by --serve in this terminal\n"
+              << "\n"
+              << "  --trace FILE         After a headless or benchmark run, write the most recent\n"
+              << "                       stage timings as Chrome trace JSON ([T] in interactive mode,\n"
+              << "                       on exit with --serve)\n";
+}
+
 int main(int argc, char* argv[]) {
     // Default paths
     const char* obj_path = "assets/vokselia_spawn/vokselia_spawn.obj";
     const char* tex_path = "assets/vokselia_spawn/vokselia_spawn.png";
+    const char* scene_path = nullptr;
     
-    // Allow custom paths from command line
-    if (argc >= 2) obj_path = argv[1];
-    if (argc >= 3) tex_path = argv[2];
-    
-    // Load mesh
-    Mesh mesh;
-    if (!mesh.load_obj(obj_path)) {
-        std::cerr << "Failed to load mesh from: " << obj_path << std::endl;
+    bool headless = false;
+    bool bench = false;
+    OfflineOptions offline;
+    BenchOptions bench_options;
+    const char* trace_path = nullptr;
+    const char* serve_path = nullptr;
+    const char* connect_path = nullptr;
+    const char* cache_path = nullptr;
+    bool reproject = false;
+    int reproject_refresh = 30;
+    double target_fps = 0;
+    float min_scale = 0.25f;
+    bool detect_output = true;
+    TerminalBackend output = TerminalBackend::BLOCKS;
+    KittyTransfer kitty_transfer = KittyTransfer::ZLIB;
+    ColorMode colors = ColorMode::TRUECOLOR;
+    bool dither = false;
+    double bandwidth = 0;
+    const char* record_path = nullptr;
+    const char* replay_path = nullptr;
+    double replay_speed = 1.0;
+    const char* capture_path = nullptr;
+    FrameCapture::Format capture_format = FrameCapture::Format::Y4M;
+    int capture_fps = 30;
+
+    // Allow custom paths and options from command line
+    int positional = 0;
+    for (int i = 1; i < argc; i++) {
+        const char* arg = argv[i];
+        bool has_value = (i + 1 < argc);
+
+        if (strcmp(arg, "--headless") == 0) {
+            headless = true;
+        } else if (strcmp(arg, "--size") == 0 && has_value) {
+            if (sscanf(argv[++i], "%dx%d", &offline.width, &offline.height) != 2 ||
+                offline.width <= 0 || offline.height <= 0) {
+                std::cerr << "Invalid --size, expected WxH: " << argv[i] << std::endl;
+                return 1;
+            }
+        } else if (strcmp(arg, "--poses") == 0 && has_value) {
+            offline.poses_path = argv[++i];
+        } else if (strcmp(arg, "--interpolate") == 0 && has_value) {
+            offline.interpolate = std::max(0, atoi(argv[++i]));
+        } else if (strcmp(arg, "--out") == 0 && has_value) {
+            offline.out_pattern = argv[++i];
+            if (!valid_frame_pattern(offline.out_pattern)) {
+                std::cerr << "Invalid --out, expected one %d for the frame number (e.g. frame_%05d.png): "
+                          << offline.out_pattern << std::endl;
+                return 1;
+            }
+        } else if (strcmp(arg, "--format") == 0 && has_value) {
+            const char* format = argv[++i];
+            if (strcmp(format, "png") == 0) {
+                offline.format = OfflineOptions::Format::PNG;
+            } else if (strcmp(format, "raw") == 0) {
+                offline.format = OfflineOptions::Format::RAW;
+            } else {
+                std::cerr << "Unknown --format: " << format << std::endl;
+                return 1;
+            }
+        } else if (strcmp(arg, "--encode-threads") == 0 && has_value) {
+            offline.encode_threads = atoi(argv[++i]);
+        } else if (strcmp(arg, "--png-bands") == 0 && has_value) {
+            offline.png_bands = atoi(argv[++i]);
+        } else if (strcmp(arg, "--bench") == 0) {
+            bench = true;
+        } else if (strcmp(arg, "--bench-frames") == 0 && has_value) {
+            bench_options.frames = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(arg, "--bench-warmup") == 0 && has_value) {
+            bench_options.warmup = std::max(0, atoi(argv[++i]));
+        } else if (strcmp(arg, "--bench-json") == 0 && has_value) {
+            bench_options.json_path = argv[++i];
+        } else if (strcmp(arg, "--bench-sink") == 0 && has_value) {
+            bench_options.sink_path = argv[++i];
+        } else if (strcmp(arg, "--reproject") == 0) {
+            reproject = true;
+        } else if (strcmp(arg, "--reproject-refresh") == 0 && has_value) {
+            reproject_refresh = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(arg, "--target-fps") == 0 && has_value) {
+            target_fps = std::max(0.0, atof(argv[++i]));
+        } else if (strcmp(arg, "--min-scale") == 0 && has_value) {
+            min_scale = std::clamp(static_cast<float>(atof(argv[++i])), 0.05f, 1.0f);
+        } else if (strcmp(arg, "--output") == 0 && has_value) {
+            const char* mode = argv[++i];
+            detect_output = strcmp(mode, "auto") == 0;
+            if (strcmp(mode, "blocks") == 0) {
+                output = TerminalBackend::BLOCKS;
+            } else if (strcmp(mode, "sixel") == 0) {
+                output = TerminalBackend::SIXEL;
+            } else if (strcmp(mode, "kitty") == 0) {
+                output = TerminalBackend::KITTY;
+            } else if (strcmp(mode, "quadrant") == 0) {
+                output = TerminalBackend::QUADRANT;
+            } else if (strcmp(mode, "sextant") == 0) {
+                output = TerminalBackend::SEXTANT;
+            } else if (!detect_output) {
+                std::cerr << "Unknown --output: " << mode << std::endl;
+                return 1;
+            }
+        } else if (strcmp(arg, "--colors") == 0 && has_value) {
+            const char* mode = argv[++i];
+            if (strcmp(mode, "truecolor") == 0) {
+                colors = ColorMode::TRUECOLOR;
+            } else if (strcmp(mode, "256") == 0) {
+                colors = ColorMode::XTERM256;
+            } else if (strcmp(mode, "16") == 0) {
+                colors = ColorMode::ANSI16;
+            } else {
+                std::cerr << "Unknown --colors: " << mode << std::endl;
+                return 1;
+            }
+        } else if (strcmp(arg, "--dither") == 0) {
+            dither = true;
+        } else if (strcmp(arg, "--bandwidth") == 0 && has_value) {
+            char* suffix = nullptr;
+            bandwidth = strtod(argv[++i], &suffix);
+            if (*suffix == 'k' || *suffix == 'K') bandwidth *= 1e3;
+            if (*suffix == 'M') bandwidth *= 1e6;
+            bandwidth = std::max(0.0, bandwidth);
+        } else if (strcmp(arg, "--kitty-transfer") == 0 && has_value) {
+            const char* transfer = argv[++i];
+            if (strcmp(transfer, "zlib") == 0) {
+                kitty_transfer = KittyTransfer::ZLIB;
+            } else if (strcmp(transfer, "shm") == 0) {
+                kitty_transfer = KittyTransfer::SHM;
+            } else {
+                std::cerr << "Unknown --kitty-transfer: " << transfer << std::endl;
+                return 1;
+            }
+        } else if (strcmp(arg, "--record") == 0 && has_value) {
+            record_path = argv[++i];
+        } else if (strcmp(arg, "--replay") == 0 && has_value) {
+            replay_path = argv[++i];
+        } else if (strcmp(arg, "--replay-speed") == 0 && has_value) {
+            replay_speed = std::max(0.0, atof(argv[++i]));
+        } else if (strcmp(arg, "--capture") == 0 && has_value) {
+            capture_path = argv[++i];
+        } else if (strcmp(arg, "--capture-format") == 0 && has_value) {
+            const char* format = argv[++i];
+            if (strcmp(format, "y4m") == 0) {
+                capture_format = FrameCapture::Format::Y4M;
+            } else if (strcmp(format, "raw") == 0) {
+                capture_format = FrameCapture::Format::RAW;
+            } else {
+                std::cerr << "Unknown --capture-format: " << format << std::endl;
+                return 1;
+            }
+        } else if (strcmp(arg, "--capture-fps") == 0 && has_value) {
+            capture_fps = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(arg, "--trace") == 0 && has_value) {
+            trace_path = argv[++i];
+        } else if (strcmp(arg, "--scene") == 0 && has_value) {
+            scene_path = argv[++i];
+        } else if (strcmp(arg, "--scene-cache") == 0 && has_value) {
+            cache_path = argv[++i];
+        } else if (strcmp(arg, "--serve") == 0 && has_value) {
+            serve_path = argv[++i];
+        } else if (strcmp(arg, "--connect") == 0 && has_value) {
+            connect_path = argv[++i];
+        } else if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+            print_usage(argv[0]);
+            return 0;
+        } else if (arg[0] == '-' && arg[1] == '-') {
+            std::cerr << "Unknown or incomplete option: " << arg << std::endl;
+            print_usage(argv[0]);
+            return 1;
+        } else if (positional == 0) {
+            obj_path = arg;
+            positional++;
+        } else if (positional == 1) {
+            tex_path = arg;
+            positional++;
+        }
+    }
+
+    // Replaying needs neither the scene nor a renderer
+    if (replay_path) return replay_tty_recording(replay_path, replay_speed);
+
+#ifdef _WIN32
+    if (serve_path || connect_path) {
+        std::cerr << "--serve and --connect require Unix domain sockets" << std::endl;
         return 1;
     }
+#else
+    // Viewers render nothing themselves, so skip loading the scene
+    if (connect_path) return run_client(connect_path);
+#endif
+
+    // Keep stdout machine-readable in benchmark mode: loading logs go to stderr
+    std::streambuf* stdout_buf = std::cout.rdbuf();
+    if (bench) std::cout.rdbuf(std::cerr.rdbuf());
     
-    // Load texture
-    Texture texture;
-    if (!texture.load(tex_path)) {
-        std::cerr << "Warning: Failed to load texture, using default color" << std::endl;
+    Scene scene;
+    Texture texture;    // Used by meshes without a texture of their own
+    const char* gltf_path = scene_path ? (is_gltf_path(scene_path) ? scene_path : nullptr)
+                                       : (is_gltf_path(obj_path) ? obj_path : nullptr);
+    // The scene cache holds a single mesh, so scene files and glTF are always parsed
+    if (cache_path && (scene_path || gltf_path)) {
+        std::cerr << "Warning: --scene-cache only applies to a single OBJ mesh, ignoring it for "
+                  << (scene_path ? scene_path : gltf_path) << std::endl;
+    }
+    if (gltf_path) {
+        // glTF files carry their own materials and node transforms
+        if (!load_gltf(gltf_path, scene)) return 1;
+    } else if (scene_path) {
+        if (!scene.load(scene_path)) return 1;
+    } else {
+        Mesh mesh;
+        SceneCacheLock cache_lock(cache_path);  // Held until the cache is published
+        if (!cache_path || !load_scene_cache(cache_path, obj_path, tex_path, mesh, texture)) {
+            // Load mesh
+            if (!mesh.load_obj(obj_path)) {
+                std::cerr << "Failed to load mesh from: " << obj_path << std::endl;
+                return 1;
+            }
+        
+            // Load texture
+            if (!texture.load(tex_path)) {
+                std::cerr << "Warning: Failed to load texture, using default color" << std::endl;
+            }
+
+            // Publish the decoded scene, then map it like every later process will
+            if (cache_path && write_scene_cache(cache_path, obj_path, tex_path, mesh, texture)) {
+                load_scene_cache(cache_path, obj_path, tex_path, mesh, texture);
+            }
+        }
+        scene.add_mesh(std::move(mesh));
+        scene.add_instance(0);
     }
     
-    // Get mesh bounds for auto-centering
+#ifndef _WIN32
+    if (serve_path) {
+        RenderServer server(scene, texture);
+        int status = server.run(serve_path);
+        if (trace_path && !Tracer::instance().write_json(trace_path)) {
+            std::cerr << "Failed to write trace: " << trace_path << std::endl;
+            return 1;
+        }
+        return status;
+    }
+#endif
+
+    if (bench || headless) {
+        int status;
+        if (bench) {
+            std::cout.rdbuf(stdout_buf);
+            bench_options.reproject = reproject;
+            bench_options.reproject_refresh = reproject_refresh;
+            bench_options.output = output;
+            bench_options.colors = colors;
+            bench_options.dither = dither;
+            status = run_bench(scene, texture, scene_path ? scene_path : obj_path, offline.width, offline.height,
+                               bench_options);
+        } else {
+            status = run_offline(scene, texture, offline);
+        }
+        if (trace_path && !Tracer::instance().write_json(trace_path)) {
+            std::cerr << "Failed to write trace: " << trace_path << std::endl;
+            return 1;
+        }
+        return status;
+    }
+    
+    // Get scene bounds for auto-centering
     HMM_Vec3 mesh_center;
     float mesh_scale;
-    mesh.get_bounds(mesh_center, mesh_scale);
+    scene.get_bounds(mesh_center, mesh_scale);
     
     // Get initial terminal size
     int term_width, term_height;
@@ -684,9 +961,12 @@ int main(int argc, char* argv[]) {
     
     // Calculate render dimensions
     // term_height includes status rows, subtract them for actual render area
-    // Each character row represents 2 pixel rows (using half-block characters)
+    // Each character row represents 2 pixel rows (half blocks; set per backend below)
     int screen_width = term_width;
-    int screen_height = std::max(1, term_height - STATUS_ROWS);  // Character rows for rendering
+    bool show_profiler = false;   // Counter overlay below the status line, toggled with [O]
+    bool layout_changed = false;  // Status area grew or shrank, recompute render size
+    int status_rows = STATUS_ROWS;
+    int screen_height = std::max(1, term_height - status_rows);  // Character rows for rendering
     int pixel_height = screen_height * 2;  // Actual pixel height
     
     // Create framebuffer
@@ -694,12 +974,8 @@ int main(int argc, char* argv[]) {
     Rasterizer rasterizer(fb);
     rasterizer.set_texture(&texture);
     
-    // Setup projection matrix (will be updated when terminal resizes)
-    auto update_projection = [](int w, int h) {
-        float aspect = static_cast<float>(w) / h;
-        return HMM_Perspective_RH_NO(HMM_AngleDeg(45.0f), aspect, 0.1f, 100.0f);
-    };
-    HMM_Mat4 projection = update_projection(screen_width, pixel_height);
+    // Model matrix: center mesh and scale to unit size
+    HMM_Mat4 model = make_model_matrix(mesh_center, mesh_scale);
     
     // ========================================================================
     // Third Person Camera Setup
@@ -707,230 +983,87 @@ int main(int argc, char* argv[]) {
     // Free camera with position and orientation
     // - WASD: Move forward/backward/left/right (relative to camera direction)
     // - QE: Move up/down
-    // - Arrow keys: Look around (yaw/pitch)
+    // - IJKL or arrow keys: Look around (yaw/pitch)
     // - R: Reset camera
     
-    // Camera control constants
-    constexpr float CAM_MOVE_SPEED = 0.15f;    // Movement speed
-    constexpr float CAM_ROTATE_SPEED = 0.06f;  // Rotation speed (radians)
-    
-    // Camera state
-    struct Camera {
-        HMM_Vec3 position = HMM_V3(0.0f, 1.0f, 3.0f);  // Camera position
-        float yaw = 0.0f;                               // Horizontal angle (radians), 0 = looking at -Z
-        float pitch = 0.0f;                             // Vertical angle (radians)
-        
-        // Get forward direction (where camera is looking, in XZ plane)
-        HMM_Vec3 get_forward() const {
-            return HMM_V3(
-                -std::sin(yaw),
-                0.0f,
-                -std::cos(yaw)
-            );
-        }
-        
-        // Get right direction
-        HMM_Vec3 get_right() const {
-            return HMM_V3(
-                std::cos(yaw),
-                0.0f,
-                -std::sin(yaw)
-            );
-        }
-        
-        // Get look direction (includes pitch)
-        HMM_Vec3 get_look_direction() const {
-            return HMM_V3(
-                -std::sin(yaw) * std::cos(pitch),
-                std::sin(pitch),
-                -std::cos(yaw) * std::cos(pitch)
-            );
-        }
-        
-        // Movement functions
-        void move_forward(float amount) {
-            position = HMM_AddV3(position, HMM_MulV3F(get_forward(), amount));
-        }
-        
-        void move_right(float amount) {
-            position = HMM_AddV3(position, HMM_MulV3F(get_right(), amount));
-        }
-        
-        void move_up(float amount) {
-            position.Y += amount;
-        }
-        
-        void rotate_yaw(float amount) {
-            yaw += amount;
-        }
-        
-        void rotate_pitch(float amount) {
-            // Pitch limits: -1.4f to 1.4f (approx ±80 degrees)
-            pitch = std::clamp(pitch + amount, -1.4f, 1.4f);
-        }
-        
-        // Build view matrix
-        HMM_Mat4 get_view_matrix() const {
-            HMM_Vec3 target = HMM_AddV3(position, get_look_direction());
-            return HMM_LookAt_RH(position, target, HMM_V3(0, 1, 0));
-        }
-        
-        void reset() {
-            position = HMM_V3(0.0f, 1.0f, 3.0f);
-            yaw = 0.0f;
-            pitch = 0.0f;
-        }
-    } camera;
+    Camera camera;
+    ViewLayout layout = ViewLayout::SINGLE;   // Cycled with [V]
+    TemporalReprojector reprojector;          // Used with --reproject in the single-view layout
+    reprojector.refresh_interval = reproject_refresh;
+    ResolutionScaler scaler;                  // Used with --target-fps
+    bool adaptive = target_fps > 0;
+    if (adaptive) {
+        scaler.target_ms = 1000.0 / target_fps;
+        scaler.min_scale = min_scale;
+    }
     
-    // Initialize terminal
+    // Initialize terminal and pick the output backend; a recording starts
+    // before anything is sent so it replays on a fresh screen
+    TtyRecorder recorder;
+    if (record_path && !recorder.open(record_path)) return 1;
+    ScreenshotWriter screenshots;
+    FrameCapture capture;
+    if (capture_path && !capture.open(capture_path, capture_format, capture_fps)) return 1;
+    watch_exit_signals();
     TerminalRenderer::init();
+    TerminalRenderer terminal(detect_output ? TerminalRenderer::detect_backend() : output);
+    terminal.kitty_transfer = kitty_transfer;
+    terminal.colors = colors;
+    terminal.dither = dither;
+    terminal.bytes_per_second = bandwidth;
+    get_terminal_cell_size(terminal.cell_width, terminal.cell_height);
+    if (terminal.backend == TerminalBackend::KITTY) signal_exit_sequence = KITTY_DELETE_IMAGES;
+    int cell_px, cell_py;
+    cell_pixels(terminal.backend, cell_px, cell_py);
+    int pixel_width = screen_width * cell_px;
+    pixel_height = screen_height * cell_py;
+    watch_terminal_resize();
+    KeyDecoder keys;
+    std::vector<int> key_events;
+    CameraController controller;
+    double frame_period = 0;    // Seconds per frame of the previous frame
+    double latency_ms = 0;      // Smoothed input-to-photon latency
+    double tx_rate = 0;         // Smoothed terminal output, bytes per second
+    std::string message;        // Last screenshot/trace result, shown on the message line
     
     std::cout << "Press Ctrl+C to exit..." << std::endl;
     
-    // Animation loop
+    // Animation loop, until Ctrl+C
     auto start_time = std::chrono::high_resolution_clock::now();
     
-    while (true) {
+    while (!exit_requested) {
+        TRACE_SCOPE("frame");
         auto current_time = std::chrono::high_resolution_clock::now();
         float elapsed = std::chrono::duration<float>(current_time - start_time).count();
         (void)elapsed;  // Available for animations if needed
         
-        // Check if terminal size changed
-        int new_term_width, new_term_height;
-        get_terminal_size(new_term_width, new_term_height);
-        
-        if (new_term_width != term_width || new_term_height != term_height) {
-            term_width = new_term_width;
-            term_height = new_term_height;
-            screen_width = term_width;
-            screen_height = std::max(1, term_height - STATUS_ROWS);
-            pixel_height = screen_height * 2;
-            
-            fb.resize(screen_width, pixel_height);
-            projection = update_projection(screen_width, pixel_height);
-            
-            // Clear screen to avoid artifacts
-            std::cout << "\033[2J" << std::flush;
-        }
-        
-        // Clear framebuffer
-        fb.clear();
-        
-        // Build model matrix: center mesh and scale to unit size (no rotation - camera orbits instead)
-        HMM_Mat4 model = HMM_M4D(1.0f);
-        model = HMM_MulM4(model, HMM_Scale(HMM_V3(2.0f / mesh_scale, 2.0f / mesh_scale, 2.0f / mesh_scale)));
-        model = HMM_MulM4(model, HMM_Translate(HMM_V3(-mesh_center.X, -mesh_center.Y, -mesh_center.Z)));
-        
-        // Get view matrix from third person camera
-        HMM_Mat4 view = camera.get_view_matrix();
-        
-        // Combined MVP matrix
-        HMM_Mat4 mvp = HMM_MulM4(projection, HMM_MulM4(view, model));
-        
-        // Normal matrix (for lighting)
-        HMM_Mat4 model_view = HMM_MulM4(view, model);
-        
-        // Render all triangles in parallel
-        int num_triangles = static_cast<int>(mesh.indices.size() / 3);
-        parallelutil::parallel_for(num_triangles, [&](int tri_idx) {
-            size_t i = tri_idx * 3;
-            std::array<HMM_Vec4, 3> clip_verts;
-            std::array<HMM_Vec2, 3> texcoords;
-            std::array<HMM_Vec3, 3> normals;
-            
-            for (int j = 0; j < 3; j++) {
-                const Vertex& v = mesh.vertices[mesh.indices[i + j]];
-                
-                // Transform vertex to clip space
-                HMM_Vec4 pos = HMM_V4(v.position.X, v.position.Y, v.position.Z, 1.0f);
-                clip_verts[j] = HMM_MulM4V4(mvp, pos);
-                
-                // Pass through texcoords
-                texcoords[j] = v.texcoord;
-                
-                // Transform normal to view space
-                HMM_Vec4 n = HMM_V4(v.normal.X, v.normal.Y, v.normal.Z, 0.0f);
-                HMM_Vec4 transformed_n = HMM_MulM4V4(model_view, n);
-                normals[j] = HMM_V3(transformed_n.X, transformed_n.Y, transformed_n.Z);
-            }
-            
-            rasterizer.draw_triangle(clip_verts, texcoords, normals);
-        });
-        
-        // Render to terminal
-        TerminalRenderer::render(fb);
-        
-        // Check for keyboard input
+        // Sample input as late as possible before the camera is used, and
+        // move the camera to where it will be when this frame is displayed
         static int screenshot_count = 0;
-        while (keyboard_hit()) {
-            int ch = get_char();
+        static int trace_count = 0;
+        int64_t input_start = Tracer::instance().now_ns();
+        double now = std::chrono::duration<double>(current_time - start_time).count();
+        key_events.clear();
+        keys.read(key_events);
+        for (int ch : key_events) {
+            if (controller.press(camera, ch, now)) continue;
+            
             switch (ch) {
                 // ============================================================
-                // Camera Movement (WASD + QE)
+                // Other Controls (camera keys are handled above)
                 // ============================================================
                 
-                // Move forward/backward
-                case 'w':
-                case 'W':
-                    camera.move_forward(CAM_MOVE_SPEED);
-                    break;
-                case 's':
-                case 'S':
-                    camera.move_forward(-CAM_MOVE_SPEED);
+                // Cycle viewport layouts
+                case 'v':
+                case 'V':
+                    layout = static_cast<ViewLayout>((static_cast<int>(layout) + 1) % static_cast<int>(ViewLayout::COUNT));
                     break;
                 
-                // Move left/right (strafe)
-                case 'a':
-                case 'A':
-                    camera.move_right(-CAM_MOVE_SPEED);
-                    break;
-                case 'd':
-                case 'D':
-                    camera.move_right(CAM_MOVE_SPEED);
-                    break;
-                
-                // Move up/down
-                case 'q':
-                case 'Q':
-                    camera.move_up(-CAM_MOVE_SPEED);
-                    break;
-                case 'e':
-                case 'E':
-                    camera.move_up(CAM_MOVE_SPEED);
-                    break;
-                
-                // ============================================================
-                // Camera Rotation (Arrow keys or IJKL)
-                // ============================================================
-                
-                // Look left/right (yaw)
-                case 'j':
-                case 'J':
-                    camera.rotate_yaw(-CAM_ROTATE_SPEED);
-                    break;
-                case 'l':
-                case 'L':
-                    camera.rotate_yaw(CAM_ROTATE_SPEED);
-                    break;
-                
-                // Look up/down (pitch)
-                case 'i':
-                case 'I':
-                    camera.rotate_pitch(CAM_ROTATE_SPEED);
-                    break;
-                case 'k':
-                case 'K':
-                    camera.rotate_pitch(-CAM_ROTATE_SPEED);
-                    break;
-                
-                // ============================================================
-                // Other Controls
-                // ============================================================
-                
-                // Reset camera to default position
-                case 'r':
-                case 'R':
-                    camera.reset();
+                // Toggle profiler overlay
+                case 'o':
+                case 'O':
+                    show_profiler = !show_profiler;
+                    layout_changed = true;
                     break;
                 
                 // Screenshot
@@ -938,17 +1071,90 @@ int main(int argc, char* argv[]) {
                 case 'P': {
                     char filename[64];
                     snprintf(filename, sizeof(filename), "screenshot_%03d.png", screenshot_count++);
-                    if (fb.save_to_file(filename)) {
-                        std::cout << "\033[" << (screen_height + 4) << ";1H";
-                        std::cout << "\033[K";  // Clear line
-                        std::cout << "Saved: " << filename << std::flush;
+                    // Only the copy happens here; "Saved" is shown once the file is written
+                    std::vector<uint8_t> rgb;
+                    fb.copy_rgb(rgb);
+                    if (!screenshots.save(filename, fb.width, fb.height, std::move(rgb))) {
+                        message = "Screenshot skipped, still writing earlier ones";
                     }
                     break;
                 }
+                
+                // Dump recent frame-stage timings as Chrome trace JSON
+                case 't':
+                case 'T': {
+                    char filename[64];
+                    snprintf(filename, sizeof(filename), "trace_%03d.json", trace_count++);
+                    if (Tracer::instance().write_json(filename)) message = std::string("Saved: ") + filename;
+                    break;
+                }
             }
         }
         
+        bool camera_moved = controller.update(camera, now, frame_period);
+        Tracer::instance().record(trace_lane, "input", input_start, Tracer::instance().now_ns());
+        
+        // Check if terminal size changed (only queried after SIGWINCH)
+        int new_term_width = term_width, new_term_height = term_height;
+        if (terminal_resized()) get_terminal_size(new_term_width, new_term_height);
+        
+        if (new_term_width != term_width || new_term_height != term_height || layout_changed) {
+            layout_changed = false;
+            term_width = new_term_width;
+            term_height = new_term_height;
+            status_rows = STATUS_ROWS + (show_profiler ? PROFILER_ROWS : 0);
+            screen_width = term_width;
+            screen_height = std::max(1, term_height - status_rows);
+            pixel_width = screen_width * cell_px;
+            pixel_height = screen_height * cell_py;
+            
+            // Clear screen to avoid artifacts
+            std::cout << "\033[2J" << std::flush;
+            terminal.invalidate();
+            get_terminal_cell_size(terminal.cell_width, terminal.cell_height);
+        }
+        
+        // Render below terminal resolution when adaptive scaling asks for it
+        int render_width = pixel_width, render_height = pixel_height;
+        if (adaptive) scaler.render_size(pixel_width, pixel_height, render_width, render_height);
+        fb.resize(render_width, render_height);
+        
+        std::vector<Viewport> views = layout_viewports(layout, fb.width, fb.height, camera, model);
+        bool reprojecting = reproject && views.size() == 1;
+        
+        // Clear framebuffer, or fill it from the previous frame
+        if (reprojecting) {
+            reprojector.begin_frame(fb, rasterizer, views[0].mvp);
+        } else {
+            TRACE_SCOPE("clear");
+            reprojector.invalidate();
+            rasterizer.set_reused_tiles(nullptr);
+            fb.clear();
+        }
+        
+        // Render all viewports' triangles in parallel
+        rasterizer.draw_items(scene.draw_list(), views);
+        if (reprojecting) reprojector.end_frame(fb, views[0].mvp);
+        
+        // Render to terminal, stretched back to full size
+        rasterizer.counters.terminal_bytes = terminal.render(fb, pixel_width, pixel_height);
+        capture.submit(fb);
+        double frame_ms = elapsed_ms(current_time);
+        
+        // Input-to-photon latency: input sampled now is on screen after
+        // frame_ms, and a key pressed at a random time waited half a frame
+        // period for the sample on average
+        double latency = frame_ms + frame_period * 500.0;
+        latency_ms = (latency_ms <= 0) ? latency : latency_ms * 0.9 + latency * 0.1;
+        
+        if (adaptive) scaler.update(frame_ms, camera_moved);
+        if (frame_period > 0) {
+            double rate = rasterizer.counters.terminal_bytes / frame_period;
+            tx_rate = tx_rate * 0.9 + rate * 0.1;
+        }
+        
         // Display FPS
+        TRACE_SCOPE("status");
         static int frame_count = 0;
         static float fps_timer = 0;
         static float fps = 0;
@@ -965,15 +1171,72 @@ int main(int argc, char* argv[]) {
         int status_row = screen_height + 2;
         std::cout << "\033[" << status_row << ";1H\033[K";
         std::cout << "FPS: " << static_cast<int>(fps)
-                  << "  Vertices: " << mesh.vertices.size()
-                  << "  Res: " << screen_width << "x" << pixel_height
+                  << "  Vertices: " << scene.vertex_count()
+                  << "  Res: " << fb.width << "x" << fb.height
                   << std::fixed << std::setprecision(1)
-                  << "  Pos: (" << camera.position.X << ", " << camera.position.Y << ", " << camera.position.Z << ")";
+                  << "  Pos: (" << camera.position.X << ", " << camera.position.Y << ", " << camera.position.Z << ")"
+                  << "  View: " << layout_name(layout)
+                  << "  Latency: " << static_cast<int>(latency_ms) << "ms";
+        if (adaptive) {
+            std::cout << "  Scale: " << static_cast<int>(std::lround(scaler.scale * 100)) << "%";
+        }
+        if (capture.is_open()) {
+            std::cout << "  Capture: " << capture.frames_written();
+            if (capture.frames_dropped() > 0) std::cout << " (" << capture.frames_dropped() << " dropped)";
+            if (capture.failed()) std::cout << " (write failed)";
+        }
+        if (bandwidth > 0) {
+            std::cout << "  TX: " << static_cast<int>(tx_rate / 1000) << "kB/s";
+        }
+        if (reproject) {
+            int reuse = reprojector.tiles_total ? 100 * reprojector.tiles_reused / reprojector.tiles_total : 0;
+            std::cout << "  Reuse: " << reuse << "%";
+        }
         
         std::cout << "\033[" << (status_row + 1) << ";1H\033[K";
-        std::cout << "[WASD] Move  [QE] Up/Down  [IJKL] Look  [R] Reset  [P] Screenshot" << std::flush;
+        std::cout << "[WASD] Move  [QE] Up/Down  [IJKL/Arrows] Look  [R] Reset  [V] Views  [P] Screenshot  [O] Profiler  [T] Trace";
+        
+        // Per-frame counters: where the triangles went, then where the pixels went
+        if (show_profiler && status_rows > STATUS_ROWS) {
+            const PipelineCounters& c = rasterizer.counters;
+            std::cout << "\033[" << (status_row + 2) << ";1H\033[K";
+            std::cout << "Tris: " << format_count(c.triangles_submitted)
+                      << " vis " << format_count(c.culled[CULL_NONE])
+                      << "  culled near " << format_count(c.culled[CULL_NEAR])
+                      << " frustum " << format_count(c.culled[CULL_FRUSTUM])
+                      << " offscreen " << format_count(c.culled[CULL_OFFSCREEN])
+                      << " subpx " << format_count(c.culled[CULL_SUBPIXEL])
+                      << " degen " << format_count(c.culled[CULL_DEGENERATE])
+                      << " back " << format_count(c.culled[CULL_BACKFACE])
+                      << " reused " << format_count(c.culled[CULL_REUSED])
+                      << "  instances culled " << format_count(c.instances_culled);
+            std::cout << "\033[" << (status_row + 3) << ";1H\033[K";
+            std::cout << "Px: tested " << format_count(c.pixels_tested)
+                      << " covered " << format_count(c.pixels_covered)
+                      << " alpha " << format_count(c.pixels_alpha_clipped)
+                      << " zfail " << format_count(c.pixels_depth_failed)
+                      << " shaded " << format_count(c.pixels_shaded)
+                      << "  CAS retry " << format_count(c.cas_retries)
+                      << "  TTY " << format_count(c.terminal_bytes) << "B";
+        }
+        std::string screenshot;
+        bool screenshot_ok;
+        while (screenshots.poll(screenshot, screenshot_ok)) {
+            message = (screenshot_ok ? "Saved: " : "Failed to save: ") + screenshot;
+        }
+        // Redrawn every frame, so it survives screen clears and profiler toggles
+        std::cout << "\033[" << (screen_height + status_rows) << ";1H\033[K" << message;
+        std::cout << std::flush;
+        recorder.end_frame();
+        frame_period = elapsed_ms(current_time) / 1000.0;
     }
     
+    // The recording ends with the last frame; what follows only restores the terminal.
+    // The capture writes out its queued frames (and waits for a |cmd pipe)
+    recorder.close();
+    capture.close();
+    terminal.finish();
     TerminalRenderer::cleanup();
+    std::cout << std::endl;
     return 0;
 }
@@ -0,0 +1,225 @@
+#pragma once
+
+#include <cmath>
+#include <algorithm>
+
+#include "HandmadeMath.h"
+#include "platform.h"
+
+// ============================================================================
+// Camera - free camera with position and yaw/pitch orientation
+// ============================================================================
+
+struct Camera {
+    HMM_Vec3 position = HMM_V3(0.0f, 1.0f, 3.0f);  // Camera position
+    float yaw = 0.0f;                               // Horizontal angle (radians), 0 = looking at -Z
+    float pitch = 0.0f;                             // Vertical angle (radians)
+    
+    // Get forward direction (where camera is looking, in XZ plane)
+    HMM_Vec3 get_forward() const {
+        return HMM_V3(
+            -std::sin(yaw),
+            0.0f,
+            -std::cos(yaw)
+        );
+    }
+    
+    // Get right direction
+    HMM_Vec3 get_right() const {
+        return HMM_V3(
+            std::cos(yaw),
+            0.0f,
+            -std::sin(yaw)
+        );
+    }
+    
+    // Get look direction (includes pitch)
+    HMM_Vec3 get_look_direction() const {
+        return HMM_V3(
+            -std::sin(yaw) * std::cos(pitch),
+            std::sin(pitch),
+            -std::cos(yaw) * std::cos(pitch)
+        );
+    }
+    
+    // Movement functions
+    void move_forward(float amount) {
+        position = HMM_AddV3(position, HMM_MulV3F(get_forward(), amount));
+    }
+    
+    void move_right(float amount) {
+        position = HMM_AddV3(position, HMM_MulV3F(get_right(), amount));
+    }
+    
+    void move_up(float amount) {
+        position.Y += amount;
+    }
+    
+    void rotate_yaw(float amount) {
+        yaw += amount;
+    }
+    
+    void rotate_pitch(float amount) {
+        // Pitch limits: -1.4f to 1.4f (approx ±80 degrees)
+        pitch = std::clamp(pitch + amount, -1.4f, 1.4f);
+    }
+    
+    // Build view matrix
+    HMM_Mat4 get_view_matrix() const {
+        HMM_Vec3 target = HMM_AddV3(position, get_look_direction());
+        return HMM_LookAt_RH(position, target, HMM_V3(0, 1, 0));
+    }
+    
+    void reset() {
+        position = HMM_V3(0.0f, 1.0f, 3.0f);
+        yaw = 0.0f;
+        pitch = 0.0f;
+    }
+};
+
+// Camera control constants
+constexpr float CAM_MOVE_SPEED = 0.15f;    // Movement per key press
+constexpr float CAM_ROTATE_SPEED = 0.06f;  // Rotation per key press (radians)
+
+// Continuous motion runs at CAM_KEY_RATE key presses' worth per second
+constexpr float CAM_KEY_RATE = 20.0f;
+
+// Camera motions bound to keys
+enum CameraAction {
+    CAM_FORWARD, CAM_BACK, CAM_LEFT, CAM_RIGHT, CAM_DOWN, CAM_UP,
+    CAM_YAW_LEFT, CAM_YAW_RIGHT, CAM_PITCH_UP, CAM_PITCH_DOWN,
+    CAM_ACTION_COUNT
+};
+
+// Map a key to the camera motion it controls:
+// - WASD: Move forward/backward/left/right (relative to camera direction)
+// - QE: Move up/down
+// - IJKL or arrow keys: Look around (yaw/pitch)
+// Returns -1 if the key is not a motion key.
+inline int camera_action(int ch) {
+    switch (ch) {
+        // ============================================================
+        // Camera Movement (WASD + QE)
+        // ============================================================
+        
+        // Move forward/backward
+        case 'w': case 'W': return CAM_FORWARD;
+        case 's': case 'S': return CAM_BACK;
+        
+        // Move left/right (strafe)
+        case 'a': case 'A': return CAM_LEFT;
+        case 'd': case 'D': return CAM_RIGHT;
+        
+        // Move up/down
+        case 'q': case 'Q': return CAM_DOWN;
+        case 'e': case 'E': return CAM_UP;
+        
+        // ============================================================
+        // Camera Rotation (Arrow keys or IJKL)
+        // ============================================================
+        
+        // Look left/right (yaw)
+        case 'j': case 'J': case KEY_LEFT: return CAM_YAW_LEFT;
+        case 'l': case 'L': case KEY_RIGHT: return CAM_YAW_RIGHT;
+        
+        // Look up/down (pitch)
+        case 'i': case 'I': case KEY_UP: return CAM_PITCH_UP;
+        case 'k': case 'K': case KEY_DOWN: return CAM_PITCH_DOWN;
+        
+        default: return -1;
+    }
+}
+
+// Apply `steps` key presses' worth of a camera motion (may be fractional)
+inline void apply_camera_action(Camera& camera, int action, float steps) {
+    float move = CAM_MOVE_SPEED * steps;
+    float rotate = CAM_ROTATE_SPEED * steps;
+    switch (action) {
+        case CAM_FORWARD: camera.move_forward(move); break;
+        case CAM_BACK: camera.move_forward(-move); break;
+        case CAM_LEFT: camera.move_right(-move); break;
+        case CAM_RIGHT: camera.move_right(move); break;
+        case CAM_DOWN: camera.move_up(-move); break;
+        case CAM_UP: camera.move_up(move); break;
+        case CAM_YAW_LEFT: camera.rotate_yaw(-rotate); break;
+        case CAM_YAW_RIGHT: camera.rotate_yaw(rotate); break;
+        case CAM_PITCH_UP: camera.rotate_pitch(rotate); break;
+        case CAM_PITCH_DOWN: camera.rotate_pitch(-rotate); break;
+    }
+}
+
+// Apply a camera control key as one discrete step; R resets the camera.
+// Returns false if the key is not a camera control.
+inline bool apply_camera_key(Camera& camera, int ch) {
+    if (ch == 'r' || ch == 'R') {
+        camera.reset();
+        return true;
+    }
+    int action = camera_action(ch);
+    if (action < 0) return false;
+    apply_camera_action(camera, action, 1.0f);
+    return true;
+}
+
+// ============================================================================
+// CameraController - time-based camera motion from terminal key events
+// ============================================================================
+//
+// Terminals only report key presses (repeated while a key is held), never
+// releases, so a key counts as held for HOLD_SECONDS after its last press;
+// auto-repeat keeps it held. Held keys move the camera at CAM_KEY_RATE
+// steps per second regardless of frame rate, and a single tap moves about
+// one step. At low frame rates the repeats of a held key arrive several per
+// frame, which also counts as held since the previous update.
+//
+// update() also predicts: it advances the camera to where it will be when
+// the frame being started is displayed (one frame time ahead), so a key
+// read just before rendering shows up in that very frame.
+
+class CameraController {
+public:
+    static constexpr double HOLD_SECONDS = 0.06;  // Longer than the usual key-repeat interval
+
+    // Record a key read at time `now` (seconds). Returns false if the key
+    // is not a camera control.
+    bool press(Camera& camera, int ch, double now) {
+        if (ch == 'r' || ch == 'R') {
+            camera.reset();
+            reset_pending = true;
+            return true;
+        }
+        int action = camera_action(ch);
+        if (action < 0) return false;
+        if (held_until[action] < now) {
+            held_since[action] = now;               // Fresh press
+        } else if (held_since[action] == now) {
+            held_since[action] = last_update;       // Repeated within one frame
+        }
+        held_until[action] = now + HOLD_SECONDS;
+        return true;
+    }
+
+    // Move `camera` through time `now + frame_seconds`. Returns true if it
+    // moved (or was reset) since the last update.
+    bool update(Camera& camera, double now, double frame_seconds) {
+        bool moved = reset_pending;
+        reset_pending = false;
+        last_update = now;
+        for (int action = 0; action < CAM_ACTION_COUNT; action++) {
+            double from = std::max(moved_until[action], held_since[action]);
+            double to = std::min(now + frame_seconds, held_until[action]);
+            if (to <= from) continue;
+            apply_camera_action(camera, action, static_cast<float>((to - from) * CAM_KEY_RATE));
+            moved_until[action] = to;
+            moved = true;
+        }
+        return moved;
+    }
+
+private:
+    double held_since[CAM_ACTION_COUNT] = {};   // Start of the current hold
+    double held_until[CAM_ACTION_COUNT] = {};   // Key counts as held until then
+    double moved_until[CAM_ACTION_COUNT] = {};  // Motion applied up to this time
+    double last_update = 0;
+    bool reset_pending = false;
+};
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <algorithm>
+
+// ============================================================================
+// Color structure (with alpha channel support)
+// ============================================================================
+
+struct Color {
+    uint8_t r, g, b, a;
+    
+    Color() : r(0), g(0), b(0), a(255) {}
+    Color(uint8_t r, uint8_t g, uint8_t b) : r(r), g(g), b(b), a(255) {}
+    Color(uint8_t r, uint8_t g, uint8_t b, uint8_t a) : r(r), g(g), b(b), a(a) {}
+    
+    Color operator*(float f) const {
+        return Color(
+            static_cast<uint8_t>(std::clamp(r * f, 0.0f, 255.0f)),
+            static_cast<uint8_t>(std::clamp(g * f, 0.0f, 255.0f)),
+            static_cast<uint8_t>(std::clamp(b * f, 0.0f, 255.0f)),
+            a  // Alpha unchanged by lighting
+        );
+    }
+    
+    Color operator+(const Color& other) const {
+        return Color(
+            static_cast<uint8_t>(std::clamp(r + other.r, 0, 255)),
+            static_cast<uint8_t>(std::clamp(g + other.g, 0, 255)),
+            static_cast<uint8_t>(std::clamp(b + other.b, 0, 255)),
+            static_cast<uint8_t>(std::clamp(a + other.a, 0, 255))
+        );
+    }
+    
+    // Check if pixel should be clipped (alpha test)
+    bool should_clip(float threshold = 0.1f) const {
+        return (a / 255.0f) < threshold;
+    }
+};
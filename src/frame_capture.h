@@ -0,0 +1,236 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "framebuffer.h"
+
+// ============================================================================
+// Frame capture - continuous video output to a file or pipe
+// ============================================================================
+//
+// submit() copies the color buffer into one of a few ring slots and returns;
+// a capture thread converts and writes the slots. When the writer falls
+// behind and every slot is taken, frames are dropped instead of stalling
+// the render loop.
+//
+// The stream has a fixed size and frame rate, as video encoders expect: the
+// first frame sets the size (later frames are rescaled to it, e.g. under
+// adaptive resolution) and each frame is shown until the next one was
+// captured: it is repeated over long frames and skipped when frames come
+// faster than the stream rate, so the stream stays in step with wall-clock
+// time.
+//
+// Formats:
+// - Y4M: YUV4MPEG2, 4:4:4 BT.601 limited range; players and ffmpeg read it
+//   without any options
+// - RAW: packed RGB24, e.g. ffmpeg -f rawvideo -pix_fmt rgb24 -s WxH -r FPS
+//
+// A destination starting with '|' is run as a shell command that reads the
+// stream on stdin (Unix), e.g. "|ffmpeg -i - capture.mp4".
+
+class FrameCapture {
+public:
+    enum class Format { Y4M, RAW };
+
+    FrameCapture() = default;
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+    ~FrameCapture() { close(); }
+
+    bool open(const char* destination, Format stream_format, int frames_per_second) {
+        format = stream_format;
+        fps = std::max(1, frames_per_second);
+#ifndef _WIN32
+        if (destination[0] == '|') {
+            signal(SIGPIPE, SIG_IGN);   // An encoder that exits early must not kill the viewer
+            out = popen(destination + 1, "w");
+            is_pipe = true;
+        } else
+#endif
+        {
+            out = fopen(destination, "wb");
+        }
+        if (!out) {
+            std::cerr << "Failed to open capture output: " << destination << std::endl;
+            return false;
+        }
+        slots.resize(SLOTS);
+        for (int i = 0; i < SLOTS; i++) free_slots.push_back(i);
+        writer = std::thread([this] { writer_loop(); });
+        return true;
+    }
+
+    bool is_open() const { return out != nullptr; }
+
+    // Frames written to the stream (after repeats) and frames dropped
+    int frames_written() const { return written.load(); }
+    int frames_dropped() const { return dropped.load(); }
+    bool failed() const { return write_failed.load(); }
+
+    // Queue the current contents of `fb`; never blocks on the writer
+    void submit(const Framebuffer& fb) {
+        if (!out || write_failed) return;
+        int slot;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (free_slots.empty()) {
+                dropped++;
+                return;
+            }
+            slot = free_slots.back();
+            free_slots.pop_back();
+        }
+        Slot& s = slots[slot];
+        s.width = fb.width;
+        s.height = fb.height;
+        s.time = std::chrono::steady_clock::now();
+        s.pixels.assign(fb.color_buffer.begin(), fb.color_buffer.begin() + static_cast<size_t>(fb.width) * fb.height);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            ready_slots.push_back(slot);
+        }
+        work_available.notify_one();
+    }
+
+    // Write what is queued and close the stream
+    void close() {
+        if (!out) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done = true;
+        }
+        work_available.notify_all();
+        writer.join();
+#ifndef _WIN32
+        if (is_pipe) {
+            pclose(out);
+        } else
+#endif
+        {
+            fclose(out);
+        }
+        out = nullptr;
+    }
+
+private:
+    static constexpr int SLOTS = 4;
+
+    struct Slot {
+        int width = 0, height = 0;
+        std::chrono::steady_clock::time_point time;
+        std::vector<Color> pixels;
+    };
+
+    Format format = Format::Y4M;
+    int fps = 30;
+    FILE* out = nullptr;
+    bool is_pipe = false;
+    std::chrono::steady_clock::time_point start;
+
+    std::vector<Slot> slots;
+    std::vector<int> free_slots;
+    std::deque<int> ready_slots;    // Oldest first
+    std::thread writer;
+    std::mutex mutex;
+    std::condition_variable work_available;
+    bool done = false;
+    std::atomic<int> written{0};
+    std::atomic<int> dropped{0};
+    std::atomic<bool> write_failed{false};
+
+    // Stream state, only touched by the writer thread
+    int stream_width = 0, stream_height = 0;
+    std::vector<uint8_t> frame;     // Most recent frame in the stream's layout
+
+    // Stream frames due by `time`, counted from the first captured frame
+    int frames_due(std::chrono::steady_clock::time_point time) const {
+        return static_cast<int>(std::chrono::duration<double>(time - start).count() * fps);
+    }
+
+    void writer_loop() {
+        while (true) {
+            int slot;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                work_available.wait(lock, [this] { return done || !ready_slots.empty(); });
+                if (ready_slots.empty()) break;
+                slot = ready_slots.front();
+                ready_slots.pop_front();
+            }
+
+            // The previous frame covers the stream up to this one
+            const Slot& s = slots[slot];
+            if (stream_width == 0) {
+                start = s.time;
+                start_stream(s.width, s.height);
+            } else {
+                while (written < frames_due(s.time) && !write_failed) write_frame();
+                fflush(out);
+            }
+            convert(s);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            free_slots.push_back(slot);
+        }
+
+        // The last frame lasts until the capture is closed, at least once
+        if (stream_width == 0) return;
+        int due = std::max(frames_due(std::chrono::steady_clock::now()), written + 1);
+        while (written < due && !write_failed) write_frame();
+    }
+
+    void start_stream(int width, int height) {
+        // 4:4:4 has no chroma subsampling, so any size works
+        stream_width = width;
+        stream_height = height;
+        if (format == Format::Y4M) {
+            fprintf(out, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", width, height, fps);
+        }
+    }
+
+    // Rescale (nearest neighbour) to the stream size and convert to the
+    // stream's pixel layout in `frame`
+    void convert(const Slot& s) {
+        size_t plane = static_cast<size_t>(stream_width) * stream_height;
+        frame.resize(plane * 3);
+        for (int y = 0; y < stream_height; y++) {
+            int sy = y * s.height / stream_height;
+            for (int x = 0; x < stream_width; x++) {
+                const Color& c = s.pixels[static_cast<size_t>(sy) * s.width + x * s.width / stream_width];
+                size_t i = static_cast<size_t>(y) * stream_width + x;
+                if (format == Format::RAW) {
+                    frame[i * 3 + 0] = c.r;
+                    frame[i * 3 + 1] = c.g;
+                    frame[i * 3 + 2] = c.b;
+                } else {
+                    // BT.601, limited range
+                    frame[i] = static_cast<uint8_t>(16 + ((66 * c.r + 129 * c.g + 25 * c.b + 128) >> 8));
+                    frame[plane + i] = static_cast<uint8_t>(128 + ((-38 * c.r - 74 * c.g + 112 * c.b + 128) >> 8));
+                    frame[plane * 2 + i] = static_cast<uint8_t>(128 + ((112 * c.r - 94 * c.g - 18 * c.b + 128) >> 8));
+                }
+            }
+        }
+    }
+
+    void write_frame() {
+        bool ok = true;
+        if (format == Format::Y4M) ok = fputs("FRAME\n", out) >= 0;
+        ok = ok && fwrite(frame.data(), 1, frame.size(), out) == frame.size();
+        if (!ok) {
+            write_failed = true;
+            return;
+        }
+        written++;
+    }
+};
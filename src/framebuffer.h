@@ -0,0 +1,135 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <limits>
+#include <cstring>
+#include <cstdint>
+
+#include "stb_image_write.h"
+#include "parallel-util.hpp"
+#include "color.h"
+#include "png_writer.h"
+
+// ============================================================================
+// Framebuffer - stores color and depth for each pixel (thread-safe)
+// ============================================================================
+
+// Helper: convert float to uint32 for atomic comparison (preserves order)
+inline uint32_t float_to_uint32(float f) {
+    uint32_t u;
+    std::memcpy(&u, &f, sizeof(u));
+    // Handle sign bit to preserve ordering: flip all bits for negative, flip sign bit for positive
+    if (u & 0x80000000) {
+        return ~u;  // Negative: flip all bits
+    } else {
+        return u ^ 0x80000000;  // Positive: flip sign bit
+    }
+}
+
+// Inverse of float_to_uint32
+inline float uint32_to_float(uint32_t u) {
+    u = (u & 0x80000000) ? (u ^ 0x80000000) : ~u;
+    float f;
+    std::memcpy(&f, &u, sizeof(f));
+    return f;
+}
+
+class Framebuffer {
+public:
+    int width, height;
+    std::vector<Color> color_buffer;
+    std::unique_ptr<std::atomic<uint32_t>[]> depth_buffer;  // Atomic array for thread-safe depth test
+    
+    Framebuffer(int w, int h) : width(w), height(h), capacity(static_cast<size_t>(w) * h) {
+        color_buffer.resize(capacity);
+        depth_buffer = std::make_unique<std::atomic<uint32_t>[]>(capacity);
+        clear();
+    }
+    
+    // Color and encoded depth of pixels no triangle covers
+    static Color background_color() { return Color(20, 20, 30); }
+    static uint32_t far_depth() { return float_to_uint32(std::numeric_limits<float>::max()); }
+    
+    void clear() {
+        Color bg_color = background_color();
+        uint32_t max_depth = far_depth();
+        
+        // Parallel clear for better performance
+        parallelutil::parallel_for(width * height, [&](int i) {
+            color_buffer[i] = bg_color;
+            depth_buffer[i].store(max_depth, std::memory_order_relaxed);
+        });
+    }
+    
+    // Thread-safe atomic depth test: stores depth and returns true if closer.
+    // Lost compare-and-swap races are added to `cas_retries`.
+    bool depth_test(int idx, float depth, uint32_t& cas_retries) {
+        uint32_t new_depth = float_to_uint32(depth);
+        uint32_t old_depth = depth_buffer[idx].load(std::memory_order_relaxed);
+        
+        // Atomic compare-and-swap loop for depth test
+        while (new_depth < old_depth) {
+            if (depth_buffer[idx].compare_exchange_weak(old_depth, new_depth,
+                    std::memory_order_relaxed, std::memory_order_relaxed)) {
+                return true;  // Won the race
+            }
+            // CAS failed, old_depth updated, retry if still closer
+            cas_retries++;
+        }
+        return false;
+    }
+    
+    // Thread-safe pixel write with atomic depth test
+    void set_pixel(int x, int y, const Color& color, float depth) {
+        if (x < 0 || x >= width || y < 0 || y >= height) return;
+        int idx = y * width + x;
+        uint32_t cas_retries = 0;
+        if (depth_test(idx, depth, cas_retries)) {
+            color_buffer[idx] = color;  // Won the race, write color
+        }
+    }
+    
+    Color get_pixel(int x, int y) const {
+        if (x < 0 || x >= width || y < 0 || y >= height) return Color();
+        return color_buffer[y * width + x];
+    }
+    
+    // Copy color buffer into a tightly packed RGB byte array
+    void copy_rgb(std::vector<uint8_t>& pixels) const {
+        pixels.resize(width * height * 3);
+        for (int i = 0; i < width * height; i++) {
+            pixels[i * 3 + 0] = color_buffer[i].r;
+            pixels[i * 3 + 1] = color_buffer[i].g;
+            pixels[i * 3 + 2] = color_buffer[i].b;
+        }
+    }
+
+    // Save framebuffer to PNG file for debugging
+    bool save_to_file(const char* filename) const {
+        std::vector<uint8_t> pixels;
+        copy_rgb(pixels);
+        return write_png(filename, width, height, pixels.data());
+    }
+    
+    // Resize framebuffer to new dimensions. Storage only grows, with headroom,
+    // so shrinking and growing back (dragging a pane, adaptive resolution)
+    // reuses the existing buffers.
+    void resize(int new_width, int new_height) {
+        if (new_width == width && new_height == height) return;
+        width = new_width;
+        height = new_height;
+        size_t size = static_cast<size_t>(width) * height;
+        if (size > capacity) {
+            capacity = size + size / 2;
+            color_buffer.reserve(capacity);
+            depth_buffer = std::make_unique<std::atomic<uint32_t>[]>(capacity);
+        }
+        color_buffer.resize(size);
+        clear();
+    }
+
+private:
+    size_t capacity;    // Pixels depth_buffer has room for
+};
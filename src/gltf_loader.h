@@ -0,0 +1,776 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "HandmadeMath.h"
+#include "parallel-util.hpp"
+#include "mesh.h"
+#include "texture.h"
+#include "scene.h"
+
+// ============================================================================
+// glTF 2.0 loader - .gltf (JSON + buffers) and .glb (single binary file)
+// ============================================================================
+//
+// Binary buffers are read once and accessors are read in place:
+// - 32-bit index accessors are used directly as Mesh::indices, without a
+//   copy, other index types are widened
+// - attributes are gathered into the interleaved Vertex layout (float
+//   positions and normals are plain copies; V is flipped to the OBJ
+//   convention Texture::sample expects)
+// Each triangle primitive becomes one scene mesh, each node that references
+// a mesh places its primitives as instances with the node's world
+// transform, so meshes reused by several nodes stay shared. The base color
+// texture of each material is decoded (embedded or external, in parallel);
+// other material properties, skins, morph targets and animations are
+// ignored. Data URIs and relative files are supported, never network URIs.
+
+namespace gltf_detail {
+
+// Minimal JSON document tree
+struct JsonValue {
+    enum class Type { NUL, BOOL, NUMBER, STRING, ARRAY, OBJECT };
+
+    Type type = Type::NUL;
+    bool boolean = false;
+    double number = 0;
+    std::string string;
+    std::vector<JsonValue> items;
+    std::vector<std::pair<std::string, JsonValue>> members;
+
+    // Member or element, or a null value when missing
+    const JsonValue& operator[](const char* key) const {
+        for (const auto& [name, value] : members) {
+            if (name == key) return value;
+        }
+        return null_value();
+    }
+    const JsonValue& operator[](size_t index) const {
+        return index < items.size() ? items[index] : null_value();
+    }
+    const JsonValue& operator[](int index) const {
+        return index >= 0 ? (*this)[static_cast<size_t>(index)] : null_value();
+    }
+
+    bool is_null() const { return type == Type::NUL; }
+    size_t size() const { return items.size(); }
+    int as_int(int fallback = -1) const {
+        return type == Type::NUMBER && number >= INT_MIN && number <= INT_MAX ? static_cast<int>(number) : fallback;
+    }
+    double as_number(double fallback = 0) const { return type == Type::NUMBER ? number : fallback; }
+    // Byte offsets and counts; out-of-range values fail later range checks
+    size_t as_size(size_t fallback = 0) const {
+        if (type != Type::NUMBER) return fallback;
+        return number >= 0 && number < 9007199254740992.0 ? static_cast<size_t>(number) : SIZE_MAX;
+    }
+
+    static const JsonValue& null_value() {
+        static const JsonValue value;
+        return value;
+    }
+};
+
+inline void append_utf8(std::string& out, uint32_t code) {
+    if (code < 0x80) {
+        out += static_cast<char>(code);
+    } else if (code < 0x800) {
+        out += static_cast<char>(0xC0 | code >> 6);
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+        out += static_cast<char>(0xE0 | code >> 12);
+        out += static_cast<char>(0x80 | (code >> 6 & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | code >> 18);
+        out += static_cast<char>(0x80 | (code >> 12 & 0x3F));
+        out += static_cast<char>(0x80 | (code >> 6 & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    }
+}
+
+class JsonParser {
+public:
+    JsonParser(const char* text, size_t size) : p(text), end(text + size) {}
+
+    bool parse(JsonValue& out) {
+        if (!value(out, 0)) return false;
+        skip_space();
+        return p == end;
+    }
+
+private:
+    static constexpr int MAX_DEPTH = 128;
+    const char* p;
+    const char* end;
+
+    void skip_space() {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')) p++;
+    }
+
+    bool literal(const char* word) {
+        size_t n = strlen(word);
+        if (static_cast<size_t>(end - p) < n || memcmp(p, word, n) != 0) return false;
+        p += n;
+        return true;
+    }
+
+    bool value(JsonValue& out, int depth) {
+        skip_space();
+        if (p == end || depth > MAX_DEPTH) return false;
+        switch (*p) {
+            case '{': return object(out, depth);
+            case '[': return array(out, depth);
+            case '"':
+                out.type = JsonValue::Type::STRING;
+                return string(out.string);
+            case 't':
+                out.type = JsonValue::Type::BOOL;
+                out.boolean = true;
+                return literal("true");
+            case 'f':
+                out.type = JsonValue::Type::BOOL;
+                return literal("false");
+            case 'n': return literal("null");
+            default: return number(out);
+        }
+    }
+
+    bool object(JsonValue& out, int depth) {
+        out.type = JsonValue::Type::OBJECT;
+        p++;
+        skip_space();
+        if (p < end && *p == '}') {
+            p++;
+            return true;
+        }
+        while (true) {
+            skip_space();
+            std::string key;
+            if (p == end || *p != '"' || !string(key)) return false;
+            skip_space();
+            if (p == end || *p++ != ':') return false;
+            out.members.emplace_back(std::move(key), JsonValue());
+            if (!value(out.members.back().second, depth + 1)) return false;
+            skip_space();
+            if (p == end) return false;
+            if (*p == '}') {
+                p++;
+                return true;
+            }
+            if (*p++ != ',') return false;
+        }
+    }
+
+    bool array(JsonValue& out, int depth) {
+        out.type = JsonValue::Type::ARRAY;
+        p++;
+        skip_space();
+        if (p < end && *p == ']') {
+            p++;
+            return true;
+        }
+        while (true) {
+            out.items.emplace_back();
+            if (!value(out.items.back(), depth + 1)) return false;
+            skip_space();
+            if (p == end) return false;
+            if (*p == ']') {
+                p++;
+                return true;
+            }
+            if (*p++ != ',') return false;
+        }
+    }
+
+    bool number(JsonValue& out) {
+        const char* start = p;
+        while (p < end && (isdigit(static_cast<unsigned char>(*p)) || *p == '-' || *p == '+' || *p == '.' ||
+                           *p == 'e' || *p == 'E')) {
+            p++;
+        }
+        if (p == start) return false;
+        std::string text(start, p);
+        char* parsed_end;
+        out.type = JsonValue::Type::NUMBER;
+        out.number = strtod(text.c_str(), &parsed_end);
+        return *parsed_end == '\0';
+    }
+
+    bool hex4(uint32_t& code) {
+        if (end - p < 4) return false;
+        code = 0;
+        for (int i = 0; i < 4; i++) {
+            char c = *p++;
+            int digit = (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10
+                      : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+            if (digit < 0) return false;
+            code = code << 4 | static_cast<uint32_t>(digit);
+        }
+        return true;
+    }
+
+    bool string(std::string& out) {
+        p++;    // Opening quote
+        while (p < end && *p != '"') {
+            char c = *p++;
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (p == end) return false;
+            c = *p++;
+            switch (c) {
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    uint32_t code;
+                    if (!hex4(code)) return false;
+                    if (code >= 0xD800 && code < 0xDC00 && end - p >= 6 && p[0] == '\\' && p[1] == 'u') {
+                        p += 2;
+                        uint32_t low;
+                        if (!hex4(low)) return false;
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    }
+                    append_utf8(out, code);
+                    break;
+                }
+                default: out += c; break;   // \" \\ \/
+            }
+        }
+        if (p == end) return false;
+        p++;    // Closing quote
+        return true;
+    }
+};
+
+// Shared, immutable bytes of one glTF buffer (or a whole GLB file)
+using Bytes = std::shared_ptr<const std::vector<uint8_t>>;
+
+struct Buffer {
+    Bytes owner;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+};
+
+// Strided view of one accessor's elements
+struct Accessor {
+    const uint8_t* data = nullptr;  // nullptr: all zeros (no buffer view)
+    Bytes owner;
+    size_t count = 0;
+    size_t stride = 0;
+    int components = 0;
+    int component_type = 0;
+    bool normalized = false;
+
+    float get(size_t element, int component) const {
+        if (!data) return 0.0f;
+        const uint8_t* at = data + element * stride;
+        switch (component_type) {
+            case 5126: {
+                float v;
+                memcpy(&v, at + component * 4, 4);
+                return v;
+            }
+            case 5121: return normalized ? at[component] / 255.0f : at[component];
+            case 5120: {
+                float v = static_cast<int8_t>(at[component]);
+                return normalized ? std::max(v / 127.0f, -1.0f) : v;
+            }
+            case 5123: case 5122: {
+                uint16_t raw;
+                memcpy(&raw, at + component * 2, 2);
+                if (component_type == 5122) {
+                    float v = static_cast<int16_t>(raw);
+                    return normalized ? std::max(v / 32767.0f, -1.0f) : v;
+                }
+                return normalized ? raw / 65535.0f : raw;
+            }
+            case 5125: {
+                uint32_t v;
+                memcpy(&v, at + component * 4, 4);
+                return static_cast<float>(v);
+            }
+            default: return 0.0f;
+        }
+    }
+
+    uint32_t get_index(size_t element) const {
+        if (!data) return 0;
+        const uint8_t* at = data + element * stride;
+        switch (component_type) {
+            case 5121: return at[0];
+            case 5123: {
+                uint16_t v;
+                memcpy(&v, at, 2);
+                return v;
+            }
+            default: {
+                uint32_t v;
+                memcpy(&v, at, 4);
+                return v;
+            }
+        }
+    }
+};
+
+inline int component_size(int component_type) {
+    switch (component_type) {
+        case 5120: case 5121: return 1;
+        case 5122: case 5123: return 2;
+        case 5125: case 5126: return 4;
+        default: return 0;
+    }
+}
+
+inline int type_components(const std::string& type) {
+    if (type == "SCALAR") return 1;
+    if (type == "VEC2") return 2;
+    if (type == "VEC3") return 3;
+    if (type == "VEC4") return 4;
+    if (type == "MAT4") return 16;
+    return 0;
+}
+
+inline bool decode_base64(const char* text, size_t size, std::vector<uint8_t>& out) {
+    auto value = [](char c) {
+        if (c >= 'A' && c <= 'Z') return c - 'A';
+        if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+        if (c >= '0' && c <= '9') return c - '0' + 52;
+        if (c == '+' || c == '-') return 62;
+        if (c == '/' || c == '_') return 63;
+        return -1;
+    };
+    uint32_t bits = 0;
+    int count = 0;
+    for (size_t i = 0; i < size && text[i] != '='; i++) {
+        int v = value(text[i]);
+        if (v < 0) return false;
+        bits = bits << 6 | static_cast<uint32_t>(v);
+        if (++count == 4) {
+            out.push_back(static_cast<uint8_t>(bits >> 16));
+            out.push_back(static_cast<uint8_t>(bits >> 8));
+            out.push_back(static_cast<uint8_t>(bits));
+            bits = 0;
+            count = 0;
+        }
+    }
+    if (count == 2) out.push_back(static_cast<uint8_t>(bits >> 4));
+    if (count == 3) {
+        out.push_back(static_cast<uint8_t>(bits >> 10));
+        out.push_back(static_cast<uint8_t>(bits >> 2));
+    }
+    return count != 1;
+}
+
+inline bool read_file(const std::string& path, std::vector<uint8_t>& out) {
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(path, error)) return false;
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    out.resize(size > 0 ? static_cast<size_t>(size) : 0);
+    bool ok = size >= 0 && fread(out.data(), 1, out.size(), f) == out.size();
+    fclose(f);
+    return ok;
+}
+
+// Bytes referenced by a URI: a base64 data URI or a file relative to `base`
+inline bool load_uri(const std::string& uri, const std::filesystem::path& base, std::vector<uint8_t>& out) {
+    if (uri.compare(0, 5, "data:") == 0) {
+        size_t comma = uri.find(',');
+        if (comma == std::string::npos || uri.rfind(";base64", comma) == std::string::npos) return false;
+        return decode_base64(uri.data() + comma + 1, uri.size() - comma - 1, out);
+    }
+    if (uri.find("://") != std::string::npos) return false;
+    std::string path;   // Percent-decoded
+    for (size_t i = 0; i < uri.size(); i++) {
+        if (uri[i] == '%' && i + 2 < uri.size() && isxdigit(static_cast<unsigned char>(uri[i + 1])) &&
+            isxdigit(static_cast<unsigned char>(uri[i + 2]))) {
+            path += static_cast<char>(strtol(uri.substr(i + 1, 2).c_str(), nullptr, 16));
+            i += 2;
+        } else {
+            path += uri[i];
+        }
+    }
+    return read_file((base / path).string(), out);
+}
+
+class GltfLoader {
+public:
+    GltfLoader(const char* path, Scene& scene) : path(path), scene(scene) {}
+
+    bool load() {
+        auto start = std::chrono::steady_clock::now();
+        if (!read_document()) return false;
+
+        // Meshes are created from primitives on first use, so unused ones cost nothing
+        const JsonValue& scenes = doc["scenes"];
+        std::vector<int> roots;
+        if (scenes.size() > 0) {
+            const JsonValue& nodes = scenes[doc["scene"].as_int(0)]["nodes"];
+            for (const JsonValue& node : nodes.items) roots.push_back(node.as_int());
+        } else {
+            // No scene: every node that is nobody's child
+            std::vector<bool> is_child(doc["nodes"].size());
+            for (const JsonValue& node : doc["nodes"].items) {
+                for (const JsonValue& child : node["children"].items) {
+                    if (child.as_int() >= 0 && child.as_int() < static_cast<int>(is_child.size())) is_child[child.as_int()] = true;
+                }
+            }
+            for (size_t i = 0; i < is_child.size(); i++) {
+                if (!is_child[i]) roots.push_back(static_cast<int>(i));
+            }
+        }
+        if (!decode_textures()) return false;
+        size_t first_instance = scene.instance_count();
+        std::vector<uint8_t> visited(doc["nodes"].size());
+        for (int root : roots) {
+            if (!visit(root, visited)) return false;
+        }
+        if (scene.instance_count() == first_instance) {
+            std::cerr << "No triangle meshes in " << path << std::endl;
+            return false;
+        }
+
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Loaded glTF " << path << ": " << primitive_meshes.size() << " meshes, "
+                  << scene.instance_count() - first_instance << " instances, " << image_textures.size()
+                  << " textures in " << std::fixed << std::setprecision(1) << ms << "ms" << std::defaultfloat
+                  << std::endl;
+        return true;
+    }
+
+private:
+    const char* path;
+    Scene& scene;
+    JsonValue doc;
+    std::vector<Buffer> buffers;
+    std::map<int, const Texture*> image_textures;              // Image index -> decoded texture
+    std::map<std::pair<int, int>, int> primitive_meshes;       // (mesh, primitive) -> scene mesh
+
+    bool fail(const std::string& message) {
+        std::cerr << path << ": " << message << std::endl;
+        return false;
+    }
+
+    bool read_document() {
+        auto file = std::make_shared<std::vector<uint8_t>>();
+        if (!read_file(path, *file)) return fail("cannot read file");
+        std::filesystem::path base = std::filesystem::path(path).parent_path();
+
+        // GLB: 12-byte header, then chunks of u32 length, u32 type, data
+        const char* json = reinterpret_cast<const char*>(file->data());
+        size_t json_size = file->size();
+        Buffer glb_bin;
+        auto u32 = [&file](size_t offset) {
+            uint32_t v;
+            memcpy(&v, file->data() + offset, 4);
+            return v;
+        };
+        if (file->size() >= 12 && u32(0) == 0x46546C67) {   // "glTF"
+            if (u32(4) != 2) return fail("unsupported GLB version");
+            json = nullptr;
+            size_t offset = 12, total = std::min<size_t>(u32(8), file->size());
+            while (offset + 8 <= total) {
+                uint32_t length = u32(offset), type = u32(offset + 4);
+                if (offset + 8 + length > total) return fail("truncated GLB chunk");
+                if (type == 0x4E4F534A && !json) {             // "JSON"
+                    json = reinterpret_cast<const char*>(file->data() + offset + 8);
+                    json_size = length;
+                } else if (type == 0x004E4942 && !glb_bin.data) {  // "BIN\0"
+                    glb_bin = {file, file->data() + offset + 8, length};
+                }
+                offset += 8 + ((length + 3) & ~size_t(3));
+            }
+            if (!json) return fail("GLB has no JSON chunk");
+        }
+
+        JsonParser parser(json, json_size);
+        if (!parser.parse(doc) || doc.type != JsonValue::Type::OBJECT) return fail("invalid JSON");
+        if (doc["asset"]["version"].string.compare(0, 2, "2.") != 0) return fail("not a glTF 2.0 asset");
+
+        for (const JsonValue& buffer : doc["buffers"].items) {
+            const std::string& uri = buffer["uri"].string;
+            if (uri.empty()) {
+                // The GLB-stored buffer
+                if (!glb_bin.data) return fail("buffer without uri or GLB binary chunk");
+                buffers.push_back(glb_bin);
+                continue;
+            }
+            auto bytes = std::make_shared<std::vector<uint8_t>>();
+            if (!load_uri(uri, base, *bytes)) return fail("cannot load buffer " + uri.substr(0, 64));
+            buffers.push_back({bytes, bytes->data(), bytes->size()});
+        }
+        return true;
+    }
+
+    bool buffer_view(int index, const uint8_t*& data, size_t& size, size_t& stride, Bytes& owner) {
+        const JsonValue& view = doc["bufferViews"][index];
+        int buffer = view["buffer"].as_int();
+        if (view.is_null() || buffer < 0 || buffer >= static_cast<int>(buffers.size())) {
+            return fail("invalid buffer view");
+        }
+        size_t offset = view["byteOffset"].as_size();
+        size = view["byteLength"].as_size();
+        if (offset > buffers[buffer].size || size > buffers[buffer].size - offset) return fail("buffer view out of range");
+        data = buffers[buffer].data + offset;
+        stride = view["byteStride"].as_size();
+        if (stride > 252) return fail("invalid byte stride");
+        owner = buffers[buffer].owner;
+        return true;
+    }
+
+    bool accessor(int index, Accessor& out) {
+        const JsonValue& a = doc["accessors"][index];
+        if (a.is_null()) return fail("invalid accessor");
+        if (!a["sparse"].is_null()) return fail("sparse accessors are not supported");
+        out.count = a["count"].as_size();
+        out.components = type_components(a["type"].string);
+        out.component_type = a["componentType"].as_int(0);
+        out.normalized = a["normalized"].boolean;
+        size_t element_size = static_cast<size_t>(out.components) * component_size(out.component_type);
+        if (element_size == 0) return fail("unsupported accessor type");
+        if (out.count > UINT32_MAX) return fail("accessor count out of range");
+        if (a["bufferView"].is_null()) return true;     // All zeros
+
+        const uint8_t* data;
+        size_t size, stride;
+        if (!buffer_view(a["bufferView"].as_int(), data, size, stride, out.owner)) return false;
+        size_t offset = a["byteOffset"].as_size();
+        out.stride = stride ? stride : element_size;
+        if (out.count > 0 && (offset > size || (out.count - 1) * out.stride + element_size > size - offset)) {
+            return fail("accessor out of range");
+        }
+        out.data = data + offset;
+        return true;
+    }
+
+    // Decode the base color images of all materials, in parallel
+    bool decode_textures() {
+        std::vector<int> images;
+        for (const JsonValue& material : doc["materials"].items) {
+            int texture = material["pbrMetallicRoughness"]["baseColorTexture"]["index"].as_int();
+            int image = doc["textures"][texture]["source"].as_int();
+            if (image >= 0 && image < static_cast<int>(doc["images"].size()) &&
+                std::find(images.begin(), images.end(), image) == images.end()) {
+                images.push_back(image);
+            }
+        }
+
+        std::filesystem::path base = std::filesystem::path(path).parent_path();
+        std::vector<Texture> decoded(images.size());
+        std::vector<uint8_t> ok(images.size());
+        std::vector<std::string> errors(images.size());
+        // Buffer views are looked up first: buffer_view() reports errors, which is not thread-safe
+        std::vector<std::span<const uint8_t>> embedded(images.size());
+        for (size_t i = 0; i < images.size(); i++) {
+            const JsonValue& image = doc["images"][images[i]];
+            if (!image["bufferView"].is_null()) {
+                const uint8_t* data;
+                size_t size, stride;
+                Bytes owner;
+                if (!buffer_view(image["bufferView"].as_int(), data, size, stride, owner)) return false;
+                embedded[i] = {data, size};
+            }
+        }
+        parallelutil::queue_based_parallel_for(static_cast<int>(images.size()), [&](int i) {
+            const JsonValue& image = doc["images"][images[i]];
+            std::string name = "image " + std::to_string(images[i]);
+            if (!embedded[i].empty()) {
+                ok[i] = decoded[i].load_from_memory(embedded[i].data(), embedded[i].size(), name.c_str(), false);
+                return;
+            }
+            std::vector<uint8_t> bytes;
+            if (!load_uri(image["uri"].string, base, bytes)) {
+                errors[i] = "cannot load image " + image["uri"].string.substr(0, 64);
+                return;
+            }
+            ok[i] = decoded[i].load_from_memory(bytes.data(), bytes.size(), name.c_str(), false);
+        }, worker_count());
+
+        for (size_t i = 0; i < images.size(); i++) {
+            if (!errors[i].empty()) return fail(errors[i]);
+            if (!ok[i]) return fail("cannot decode image " + std::to_string(images[i]));
+            image_textures[images[i]] = scene.add_texture(std::move(decoded[i]));
+        }
+        return true;
+    }
+
+    const Texture* material_texture(int material) {
+        int texture = doc["materials"][material]["pbrMetallicRoughness"]["baseColorTexture"]["index"].as_int();
+        auto it = image_textures.find(doc["textures"][texture]["source"].as_int());
+        return it != image_textures.end() ? it->second : nullptr;
+    }
+
+    // Scene mesh of a triangle primitive, -1 for other modes
+    bool primitive_mesh(int mesh_index, int primitive_index, int& out) {
+        auto key = std::make_pair(mesh_index, primitive_index);
+        if (auto it = primitive_meshes.find(key); it != primitive_meshes.end()) {
+            out = it->second;
+            return true;
+        }
+        const JsonValue& primitive = doc["meshes"][mesh_index]["primitives"][primitive_index];
+        out = -1;
+        if (primitive["mode"].as_int(4) != 4) {
+            std::cerr << path << ": skipping non-triangle primitive" << std::endl;
+            primitive_meshes[key] = out;
+            return true;
+        }
+
+        const JsonValue& attributes = primitive["attributes"];
+        Accessor position, normal, texcoord, indices;
+        if (attributes["POSITION"].is_null()) return fail("primitive without POSITION");
+        if (!accessor(attributes["POSITION"].as_int(), position)) return false;
+        if (position.components != 3) return fail("POSITION must be VEC3");
+        bool has_normal = !attributes["NORMAL"].is_null();
+        bool has_texcoord = !attributes["TEXCOORD_0"].is_null();
+        if (has_normal && (!accessor(attributes["NORMAL"].as_int(), normal) || normal.count < position.count)) {
+            return fail("invalid NORMAL");
+        }
+        if (has_texcoord && (!accessor(attributes["TEXCOORD_0"].as_int(), texcoord) || texcoord.count < position.count)) {
+            return fail("invalid TEXCOORD_0");
+        }
+
+        // Storage and the buffer the indices may point into live as long as the mesh
+        struct Storage {
+            std::vector<Vertex> vertices;
+            std::vector<unsigned int> indices;
+            Bytes buffer;
+        };
+        auto storage = std::make_shared<Storage>();
+        storage->vertices.resize(position.count);
+        for (size_t i = 0; i < position.count; i++) {
+            Vertex& v = storage->vertices[i];
+            v.position = HMM_V3(position.get(i, 0), position.get(i, 1), position.get(i, 2));
+            v.normal = has_normal ? HMM_V3(normal.get(i, 0), normal.get(i, 1), normal.get(i, 2)) : HMM_V3(0, 1, 0);
+            v.texcoord = has_texcoord ? HMM_V2(texcoord.get(i, 0), 1.0f - texcoord.get(i, 1)) : HMM_V2(0, 0);
+        }
+
+        std::span<const unsigned int> index_view;
+        if (primitive["indices"].is_null()) {
+            storage->indices.resize(position.count / 3 * 3);
+            for (size_t i = 0; i < storage->indices.size(); i++) storage->indices[i] = static_cast<unsigned int>(i);
+            index_view = storage->indices;
+        } else {
+            if (!accessor(primitive["indices"].as_int(), indices)) return false;
+            if (indices.components != 1 || (indices.component_type != 5121 && indices.component_type != 5123 &&
+                                             indices.component_type != 5125)) {
+                return fail("invalid index accessor");
+            }
+            size_t count = indices.count / 3 * 3;
+            if (indices.component_type == 5125 && indices.stride == 4 && indices.data &&
+                reinterpret_cast<uintptr_t>(indices.data) % alignof(unsigned int) == 0) {
+                // Used in place
+                index_view = {reinterpret_cast<const unsigned int*>(indices.data), count};
+                storage->buffer = indices.owner;
+            } else {
+                storage->indices.resize(count);
+                for (size_t i = 0; i < count; i++) storage->indices[i] = indices.get_index(i);
+                index_view = storage->indices;
+            }
+            for (unsigned int index : index_view) {
+                if (index >= position.count) return fail("index out of range");
+            }
+        }
+
+        Mesh mesh;
+        std::span<const Vertex> vertex_view = storage->vertices;
+        mesh.set_view(vertex_view, index_view, storage);
+        std::string name = doc["meshes"][mesh_index]["name"].string;
+        name = (name.empty() ? "mesh " + std::to_string(mesh_index) : name) + "/" + std::to_string(primitive_index);
+        out = scene.add_mesh(std::move(mesh), material_texture(primitive["material"].as_int()), name);
+        primitive_meshes[key] = out;
+        return true;
+    }
+
+    static HMM_Mat4 local_transform(const JsonValue& node) {
+        const JsonValue& matrix = node["matrix"];
+        if (matrix.size() == 16) {
+            HMM_Mat4 m;
+            for (int i = 0; i < 16; i++) m.Elements[i / 4][i % 4] = static_cast<float>(matrix[i].as_number());
+            return m;
+        }
+        const JsonValue& t = node["translation"];
+        const JsonValue& r = node["rotation"];
+        const JsonValue& s = node["scale"];
+        HMM_Mat4 m = HMM_M4D(1.0f);
+        if (t.size() == 3) {
+            m = HMM_Translate(HMM_V3(static_cast<float>(t[0].as_number()), static_cast<float>(t[1].as_number()),
+                                     static_cast<float>(t[2].as_number())));
+        }
+        if (r.size() == 4) {
+            m = HMM_MulM4(m, HMM_QToM4(HMM_Q(static_cast<float>(r[0].as_number()), static_cast<float>(r[1].as_number()),
+                                             static_cast<float>(r[2].as_number()), static_cast<float>(r[3].as_number(1)))));
+        }
+        if (s.size() == 3) {
+            m = HMM_MulM4(m, HMM_Scale(HMM_V3(static_cast<float>(s[0].as_number(1)), static_cast<float>(s[1].as_number(1)),
+                                              static_cast<float>(s[2].as_number(1)))));
+        }
+        return m;
+    }
+
+    // Instance the meshes of the tree under `root`, depth first. glTF node
+    // hierarchies are disjoint trees, so a node reached twice (shared child,
+    // cycle, or root listed again) is an error rather than walked again.
+    bool visit(int root, std::vector<uint8_t>& visited) {
+        std::vector<std::pair<int, HMM_Mat4>> pending = {{root, HMM_M4D(1.0f)}};
+        while (!pending.empty()) {
+            auto [index, parent] = pending.back();
+            pending.pop_back();
+            const JsonValue& node = doc["nodes"][index];
+            if (node.is_null()) return fail("invalid node");
+            if (visited[index]) return fail("node " + std::to_string(index) + " has multiple parents");
+            visited[index] = 1;
+            HMM_Mat4 world = HMM_MulM4(parent, local_transform(node));
+
+            int mesh_index = node["mesh"].as_int();
+            if (mesh_index >= 0) {
+                if (mesh_index >= static_cast<int>(doc["meshes"].size())) return fail("invalid mesh");
+                int primitives = static_cast<int>(doc["meshes"][mesh_index]["primitives"].size());
+                for (int p = 0; p < primitives; p++) {
+                    int mesh;
+                    if (!primitive_mesh(mesh_index, p, mesh)) return false;
+                    if (mesh >= 0) scene.add_instance(mesh, world);
+                }
+            }
+            // Reversed, so children are instanced in the order they are listed
+            const auto& children = node["children"].items;
+            for (auto it = children.rbegin(); it != children.rend(); ++it) pending.emplace_back(it->as_int(), world);
+        }
+        return true;
+    }
+};
+
+}  // namespace gltf_detail
+
+inline bool is_gltf_path(const char* path) {
+    std::string extension = std::filesystem::path(path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension == ".gltf" || extension == ".glb";
+}
+
+// Add the default scene of a .gltf or .glb file to `scene`
+inline bool load_gltf(const char* path, Scene& scene) {
+    return gltf_detail::GltfLoader(path, scene).load();
+}
@@ -0,0 +1,227 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <vector>
+#include <limits>
+#include <algorithm>
+
+#include "tinyobj_loader_c.h"
+#include "HandmadeMath.h"
+#include "mesh_optimizer.h"
+
+// ============================================================================
+// Vertex structure for rendering
+// ============================================================================
+
+struct Vertex {
+    HMM_Vec3 position;
+    HMM_Vec2 texcoord;
+    HMM_Vec3 normal;
+};
+
+// ============================================================================
+// Mesh - stores geometry data
+// ============================================================================
+//
+// `vertices` and `indices` are read-only views. They point either at the
+// mesh's own storage (after load_obj/set_data) or into a memory-mapped scene
+// cache shared between processes (see scene_cache.h), kept alive by `backing`.
+// load_obj() shares vertices between faces and orders triangles spatially and
+// for vertex reuse (see mesh_optimizer.h); the scene cache stores that order.
+
+class Mesh {
+public:
+    std::span<const Vertex> vertices;
+    std::span<const unsigned int> indices;
+
+    Mesh() = default;
+    Mesh(Mesh&&) = default;             // Moving vectors keeps their buffers, so views stay valid
+    Mesh& operator=(Mesh&&) = default;
+    Mesh(const Mesh&) = delete;
+    Mesh& operator=(const Mesh&) = delete;
+
+    // Take ownership of geometry
+    void set_data(std::vector<Vertex> new_vertices, std::vector<unsigned int> new_indices) {
+        vertex_storage = std::move(new_vertices);
+        index_storage = std::move(new_indices);
+        backing.reset();
+        vertices = vertex_storage;
+        indices = index_storage;
+    }
+
+    // Reference geometry owned by `owner` (e.g. a mapped file) without copying
+    void set_view(std::span<const Vertex> new_vertices, std::span<const unsigned int> new_indices,
+                  std::shared_ptr<const void> owner) {
+        vertex_storage.clear();
+        vertex_storage.shrink_to_fit();
+        index_storage.clear();
+        index_storage.shrink_to_fit();
+        backing = std::move(owner);
+        vertices = new_vertices;
+        indices = new_indices;
+    }
+
+    // `verbose` prints a line once loaded (off when loading several in parallel)
+    bool load_obj(const char* filename, bool verbose = true) {
+        tinyobj_attrib_t attrib;
+        tinyobj_shape_t* shapes = nullptr;
+        size_t num_shapes = 0;
+        tinyobj_material_t* materials = nullptr;
+        size_t num_materials = 0;
+        
+        // File reading callback
+        auto file_reader = [](void* ctx, const char* filename, int is_mtl,
+                              const char* obj_filename, char** buf, size_t* len) {
+            (void)ctx;
+            (void)is_mtl;
+            (void)obj_filename;
+            
+            FILE* f = fopen(filename, "rb");
+            if (!f) {
+                *buf = nullptr;
+                *len = 0;
+                return;
+            }
+            
+            fseek(f, 0, SEEK_END);
+            *len = ftell(f);
+            fseek(f, 0, SEEK_SET);
+            
+            *buf = (char*)malloc(*len + 1);
+            fread(*buf, 1, *len, f);
+            (*buf)[*len] = '\0';
+            fclose(f);
+        };
+        
+        int result = tinyobj_parse_obj(&attrib, &shapes, &num_shapes,
+                                       &materials, &num_materials,
+                                       filename, file_reader, nullptr,
+                                       TINYOBJ_FLAG_TRIANGULATE);
+        
+        if (result != TINYOBJ_SUCCESS) {
+            std::cerr << "Failed to load OBJ: " << filename << std::endl;
+            return false;
+        }
+        
+        // Convert to our vertex format, sharing one vertex between all face
+        // corners with the same position, texcoord and normal indices
+        std::vector<Vertex> vertices;
+        std::vector<unsigned int> indices;
+        std::vector<int> first_of_position(attrib.num_vertices, -1);   // Chains of vertices per position
+        std::vector<int> next_of_position;
+        std::vector<std::pair<int, int>> attribute_indices;             // (texcoord, normal) per vertex
+        indices.reserve(attrib.num_faces);
+        
+        bool valid = true;
+        for (size_t i = 0; i < attrib.num_faces; i++) {
+            tinyobj_vertex_index_t idx = attrib.faces[i];
+            if (idx.v_idx < 0 || static_cast<size_t>(idx.v_idx) >= attrib.num_vertices) {
+                valid = false;
+                break;
+            }
+            int vt = (idx.vt_idx >= 0 && static_cast<size_t>(idx.vt_idx) < attrib.num_texcoords) ? idx.vt_idx : -1;
+            int vn = (idx.vn_idx >= 0 && static_cast<size_t>(idx.vn_idx) < attrib.num_normals) ? idx.vn_idx : -1;
+            int k = first_of_position[idx.v_idx];
+            while (k >= 0 && attribute_indices[k] != std::make_pair(vt, vn)) k = next_of_position[k];
+            if (k < 0) {
+                Vertex v;
+                
+                // Position
+                v.position.X = attrib.vertices[3 * idx.v_idx + 0];
+                v.position.Y = attrib.vertices[3 * idx.v_idx + 1];
+                v.position.Z = attrib.vertices[3 * idx.v_idx + 2];
+                
+                // Texcoord
+                if (vt >= 0) {
+                    v.texcoord.X = attrib.texcoords[2 * vt + 0];
+                    v.texcoord.Y = attrib.texcoords[2 * vt + 1];
+                } else {
+                    v.texcoord = HMM_V2(0, 0);
+                }
+                
+                // Normal
+                if (vn >= 0) {
+                    v.normal.X = attrib.normals[3 * vn + 0];
+                    v.normal.Y = attrib.normals[3 * vn + 1];
+                    v.normal.Z = attrib.normals[3 * vn + 2];
+                } else {
+                    v.normal = HMM_V3(0, 1, 0);
+                }
+                
+                k = static_cast<int>(vertices.size());
+                vertices.push_back(v);
+                attribute_indices.emplace_back(vt, vn);
+                next_of_position.push_back(first_of_position[idx.v_idx]);
+                first_of_position[idx.v_idx] = k;
+            }
+            indices.push_back(static_cast<unsigned int>(k));
+        }
+        
+        // Clean up
+        tinyobj_attrib_free(&attrib);
+        tinyobj_shapes_free(shapes, num_shapes);
+        tinyobj_materials_free(materials, num_materials);
+        
+        if (!valid) {
+            std::cerr << "Failed to load OBJ: " << filename << " (vertex index out of range)" << std::endl;
+            return false;
+        }
+        
+        // Spatially sorted triangles, locally reordered for vertex reuse, then
+        // vertices in the order triangles use them
+        sort_triangles_morton(std::span<unsigned int>(indices), std::span<const Vertex>(vertices));
+        optimize_vertex_cache(indices, vertices.size());
+        optimize_vertex_fetch(vertices, indices);
+        
+        if (verbose) {
+            std::cout << "Loaded mesh with " << vertices.size() << " vertices, "
+                      << indices.size() / 3 << " triangles" << std::endl;
+        }
+        set_data(std::move(vertices), std::move(indices));
+        return true;
+    }
+    
+    // Axis-aligned bounding box of the vertex positions
+    void get_box(HMM_Vec3& min_bound, HMM_Vec3& max_bound) const {
+        min_bound = HMM_V3(std::numeric_limits<float>::max(),
+                           std::numeric_limits<float>::max(),
+                           std::numeric_limits<float>::max());
+        max_bound = HMM_V3(std::numeric_limits<float>::lowest(),
+                           std::numeric_limits<float>::lowest(),
+                           std::numeric_limits<float>::lowest());
+        
+        for (const auto& v : vertices) {
+            min_bound.X = std::min(min_bound.X, v.position.X);
+            min_bound.Y = std::min(min_bound.Y, v.position.Y);
+            min_bound.Z = std::min(min_bound.Z, v.position.Z);
+            max_bound.X = std::max(max_bound.X, v.position.X);
+            max_bound.Y = std::max(max_bound.Y, v.position.Y);
+            max_bound.Z = std::max(max_bound.Z, v.position.Z);
+        }
+    }
+    
+    // Calculate bounding box and return center and scale
+    void get_bounds(HMM_Vec3& center, float& scale) const {
+        HMM_Vec3 min_bound, max_bound;
+        get_box(min_bound, max_bound);
+        box_center_scale(min_bound, max_bound, center, scale);
+    }
+
+    // Center and largest extent of a box
+    static void box_center_scale(const HMM_Vec3& min_bound, const HMM_Vec3& max_bound, HMM_Vec3& center, float& scale) {
+        center = HMM_MulV3F(HMM_AddV3(min_bound, max_bound), 0.5f);
+        float dx = max_bound.X - min_bound.X;
+        float dy = max_bound.Y - min_bound.Y;
+        float dz = max_bound.Z - min_bound.Z;
+        scale = std::max({dx, dy, dz});
+    }
+
+private:
+    std::vector<Vertex> vertex_storage;
+    std::vector<unsigned int> index_storage;
+    std::shared_ptr<const void> backing;
+};
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// ============================================================================
+// Mesh optimizer - triangle and vertex order for cache reuse
+// ============================================================================
+//
+// sort_triangles_morton() orders triangles along a Z-order curve through
+// their centroids. The pipeline hands each worker a contiguous range of
+// triangles, so this keeps every worker on a compact region of the model
+// (and so of the screen) instead of one scattered in file order, and workers
+// rarely write the same depth buffer cache lines.
+//
+// optimize_vertex_cache() then reorders triangles with Tom Forsyth's
+// linear-speed vertex cache optimization: vertices are scored by their
+// position in a simulated LRU cache and by how many of their triangles are
+// left, and the best triangle touching the cache is emitted next.
+// Consecutive triangles then share transformed vertices that are still in
+// the CPU cache. Only triangles within a window of the input order are
+// candidates, so a spatially sorted input stays sorted at that scale.
+//
+// optimize_vertex_fetch() renumbers vertices in order of first use, so the
+// vertex stage writes and the setup stage reads `transformed` nearly in order.
+
+namespace mesh_optimizer_detail {
+
+constexpr int CACHE_SIZE = 32;
+constexpr int MAX_VALENCE_SCORE = 32;
+constexpr size_t WINDOW = 4096;     // Triangles ahead of the first unemitted one that may be picked
+
+struct ScoreTables {
+    float cache[CACHE_SIZE];
+    float valence[MAX_VALENCE_SCORE];
+
+    ScoreTables() {
+        for (int i = 0; i < CACHE_SIZE; i++) {
+            if (i < 3) {
+                cache[i] = 0.75f;           // Last triangle: slight penalty, avoids strips
+            } else {
+                cache[i] = std::pow(1.0f - static_cast<float>(i - 3) / (CACHE_SIZE - 3), 1.5f);
+            }
+        }
+        valence[0] = 0.0f;
+        for (int i = 1; i < MAX_VALENCE_SCORE; i++) valence[i] = 2.0f / std::sqrt(static_cast<float>(i));
+    }
+
+    // `position` < 0: not in the cache; `remaining` = unemitted triangles using the vertex
+    float score(int position, int remaining) const {
+        if (remaining == 0) return -1.0f;
+        float s = position >= 0 ? cache[position] : 0.0f;
+        return s + valence[std::min(remaining, MAX_VALENCE_SCORE - 1)];
+    }
+};
+
+// Spread the low 21 bits of `x` to every third bit
+inline uint64_t spread_bits(uint64_t x) {
+    x &= 0x1FFFFF;
+    x = (x | x << 32) & 0x001F00000000FFFFull;
+    x = (x | x << 16) & 0x001F0000FF0000FFull;
+    x = (x | x << 8) & 0x100F00F00F00F00Full;
+    x = (x | x << 4) & 0x10C30C30C30C30C3ull;
+    x = (x | x << 2) & 0x1249249249249249ull;
+    return x;
+}
+
+}  // namespace mesh_optimizer_detail
+
+// Reorder the triangles of `indices` (in place) by the Morton code of their centroids
+template <typename V>
+inline void sort_triangles_morton(std::span<unsigned int> indices, std::span<const V> vertices) {
+    using namespace mesh_optimizer_detail;
+    size_t triangle_count = indices.size() / 3;
+    if (triangle_count < 2) return;
+
+    float lo[3] = {FLT_MAX, FLT_MAX, FLT_MAX};
+    float hi[3] = {-FLT_MAX, -FLT_MAX, -FLT_MAX};
+    for (unsigned int index : indices) {
+        const float* p = &vertices[index].position.Elements[0];
+        for (int a = 0; a < 3; a++) {
+            lo[a] = std::min(lo[a], p[a]);
+            hi[a] = std::max(hi[a], p[a]);
+        }
+    }
+    // Centroids are summed rather than averaged, hence 3x the box
+    float scale[3];
+    for (int a = 0; a < 3; a++) scale[a] = hi[a] > lo[a] ? 2097151.0f / (3.0f * (hi[a] - lo[a])) : 0.0f;
+
+    std::vector<std::pair<uint64_t, uint32_t>> keys(triangle_count);
+    for (size_t t = 0; t < triangle_count; t++) {
+        uint64_t code = 0;
+        for (int a = 0; a < 3; a++) {
+            float sum = vertices[indices[t * 3]].position.Elements[a] + vertices[indices[t * 3 + 1]].position.Elements[a] +
+                        vertices[indices[t * 3 + 2]].position.Elements[a];
+            float q = std::clamp((sum - 3.0f * lo[a]) * scale[a], 0.0f, 2097151.0f);
+            code |= spread_bits(static_cast<uint64_t>(q)) << a;
+        }
+        keys[t] = {code, static_cast<uint32_t>(t)};
+    }
+    std::sort(keys.begin(), keys.end());
+
+    std::vector<unsigned int> sorted(triangle_count * 3);
+    for (size_t t = 0; t < triangle_count; t++) {
+        std::copy_n(&indices[static_cast<size_t>(keys[t].second) * 3], 3, &sorted[t * 3]);
+    }
+    std::copy(sorted.begin(), sorted.end(), indices.begin());
+}
+
+// Reorder the triangles of `indices` (in place) for post-transform vertex reuse
+inline void optimize_vertex_cache(std::span<unsigned int> indices, size_t vertex_count) {
+    using namespace mesh_optimizer_detail;
+    static const ScoreTables tables;
+    size_t triangle_count = indices.size() / 3;
+    if (triangle_count < 2) return;
+
+    // Triangles of each vertex; emitted ones are swapped past `remaining`
+    std::vector<uint32_t> adjacency_start(vertex_count + 1, 0);
+    for (size_t i = 0; i < triangle_count * 3; i++) adjacency_start[indices[i] + 1]++;
+    for (size_t v = 0; v < vertex_count; v++) adjacency_start[v + 1] += adjacency_start[v];
+    std::vector<uint32_t> remaining(vertex_count);
+    std::vector<uint32_t> adjacency(triangle_count * 3);
+    for (size_t i = 0; i < triangle_count * 3; i++) {
+        unsigned int v = indices[i];
+        adjacency[adjacency_start[v] + remaining[v]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    std::vector<float> vertex_score(vertex_count);
+    for (size_t v = 0; v < vertex_count; v++) vertex_score[v] = tables.score(-1, static_cast<int>(remaining[v]));
+    std::vector<float> triangle_score(triangle_count);
+    for (size_t t = 0; t < triangle_count; t++) {
+        triangle_score[t] = vertex_score[indices[t * 3]] + vertex_score[indices[t * 3 + 1]] +
+                            vertex_score[indices[t * 3 + 2]];
+    }
+
+    std::vector<uint8_t> emitted(triangle_count, 0);
+    std::vector<unsigned int> output;
+    output.reserve(triangle_count * 3);
+    std::vector<unsigned int> cache, next_cache;
+    cache.reserve(CACHE_SIZE + 3);
+    next_cache.reserve(CACHE_SIZE + 3);
+    size_t cursor = 0;          // Every triangle before it has been emitted
+    int64_t best = -1;
+
+    for (size_t n = 0; n < triangle_count; n++) {
+        if (best < 0) best = static_cast<int64_t>(cursor);
+        const unsigned int* tri = &indices[best * 3];
+        output.insert(output.end(), tri, tri + 3);
+        emitted[best] = 1;
+        while (cursor < triangle_count && emitted[cursor]) cursor++;
+
+        // Detach the triangle from its vertices
+        for (int k = 0; k < 3; k++) {
+            unsigned int v = tri[k];
+            uint32_t* list = &adjacency[adjacency_start[v]];
+            for (uint32_t i = 0; i < remaining[v]; i++) {
+                if (list[i] == best) {
+                    std::swap(list[i], list[remaining[v] - 1]);
+                    remaining[v]--;
+                    break;
+                }
+            }
+        }
+
+        // Its vertices move to the front of the LRU cache
+        next_cache.clear();
+        for (int k = 0; k < 3; k++) {
+            if (std::find(next_cache.begin(), next_cache.end(), tri[k]) == next_cache.end()) next_cache.push_back(tri[k]);
+        }
+        for (unsigned int v : cache) {
+            if (std::find(next_cache.begin(), next_cache.end(), v) == next_cache.end()) next_cache.push_back(v);
+        }
+        std::swap(cache, next_cache);
+
+        // Rescore cached and evicted vertices, then pick the best triangle among their neighbours
+        for (size_t i = 0; i < cache.size(); i++) {
+            unsigned int v = cache[i];
+            float score = tables.score(i < CACHE_SIZE ? static_cast<int>(i) : -1, static_cast<int>(remaining[v]));
+            float delta = score - vertex_score[v];
+            vertex_score[v] = score;
+            const uint32_t* list = &adjacency[adjacency_start[v]];
+            for (uint32_t j = 0; j < remaining[v]; j++) triangle_score[list[j]] += delta;
+        }
+        best = -1;
+        float best_score = -1.0f;
+        for (size_t i = 0; i < std::min<size_t>(cache.size(), CACHE_SIZE); i++) {
+            unsigned int v = cache[i];
+            const uint32_t* list = &adjacency[adjacency_start[v]];
+            for (uint32_t j = 0; j < remaining[v]; j++) {
+                if (triangle_score[list[j]] > best_score && list[j] < cursor + WINDOW) {
+                    best_score = triangle_score[list[j]];
+                    best = list[j];
+                }
+            }
+        }
+        if (cache.size() > CACHE_SIZE) cache.resize(CACHE_SIZE);
+    }
+    std::copy(output.begin(), output.end(), indices.begin());
+}
+
+// Renumber vertices in order of first use in `indices`, dropping unused ones
+template <typename V>
+inline void optimize_vertex_fetch(std::vector<V>& vertices, std::span<unsigned int> indices) {
+    constexpr unsigned int UNUSED = ~0u;
+    std::vector<unsigned int> remap(vertices.size(), UNUSED);
+    std::vector<V> reordered;
+    reordered.reserve(vertices.size());
+    for (unsigned int& index : indices) {
+        if (remap[index] == UNUSED) {
+            remap[index] = static_cast<unsigned int>(reordered.size());
+            reordered.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices = std::move(reordered);
+}
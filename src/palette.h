@@ -0,0 +1,116 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+#include "color.h"
+
+// ============================================================================
+// Palette quantization - 24-bit colors to xterm-256 or 16-color indices
+// ============================================================================
+//
+// Indexed color escapes ("38;5;n", "31") are a fraction of the size of
+// "38;2;r;g;b" and survive terminals and multiplexers without truecolor.
+// Each mode has a lookup table over a 32x32x32 grid of the RGB cube, filled
+// once with the nearest palette entry, so quantizing a pixel is one load.
+//
+// Ordered dithering adds a 4x4 Bayer threshold to the color before the
+// lookup; it trades flat banding for a fixed, non-flickering pattern.
+
+enum class ColorMode { TRUECOLOR, XTERM256, ANSI16 };
+
+inline const char* color_mode_name(ColorMode mode) {
+    switch (mode) {
+        case ColorMode::XTERM256: return "256";
+        case ColorMode::ANSI16: return "16";
+        default: return "truecolor";
+    }
+}
+
+// Default xterm RGB of palette entry `index` (0-255)
+inline Color palette_color(int index) {
+    static const uint8_t system[16][3] = {
+        {0, 0, 0},       {205, 0, 0},     {0, 205, 0},     {205, 205, 0},
+        {0, 0, 238},     {205, 0, 205},   {0, 205, 205},   {229, 229, 229},
+        {127, 127, 127}, {255, 0, 0},     {0, 255, 0},     {255, 255, 0},
+        {92, 92, 255},   {255, 0, 255},   {0, 255, 255},   {255, 255, 255},
+    };
+    static const uint8_t cube[6] = {0, 95, 135, 175, 215, 255};
+    if (index < 16) return Color(system[index][0], system[index][1], system[index][2]);
+    if (index < 232) {
+        index -= 16;
+        return Color(cube[index / 36], cube[index / 6 % 6], cube[index % 6]);
+    }
+    uint8_t gray = static_cast<uint8_t>(8 + (index - 232) * 10);
+    return Color(gray, gray, gray);
+}
+
+class PaletteLUT {
+public:
+    // Table for `mode` (XTERM256 or ANSI16), built on first use
+    static const PaletteLUT& get(ColorMode mode) {
+        static const PaletteLUT xterm256(ColorMode::XTERM256);
+        static const PaletteLUT ansi16(ColorMode::ANSI16);
+        return mode == ColorMode::ANSI16 ? ansi16 : xterm256;
+    }
+
+    uint8_t lookup(const Color& c) const {
+        return table[(c.r >> 3) << 10 | (c.g >> 3) << 5 | (c.b >> 3)];
+    }
+
+    // Lookup with the ordered dither threshold of pixel (x, y)
+    uint8_t lookup(const Color& c, int x, int y) const {
+        static const int8_t bayer[4][4] = {
+            {0, 8, 2, 10}, {12, 4, 14, 6}, {3, 11, 1, 9}, {15, 7, 13, 5},
+        };
+        // Offset in [-spread/2, spread/2), the same for all channels
+        int offset = (2 * bayer[y & 3][x & 3] + 1 - 16) * spread / 32;
+        auto shift = [offset](uint8_t v) { return static_cast<uint8_t>(std::clamp(v + offset, 0, 255)); };
+        return lookup(Color(shift(c.r), shift(c.g), shift(c.b)));
+    }
+
+private:
+    std::vector<uint8_t> table;
+    int spread;     // Typical distance between neighbouring palette colors
+
+    // Perceptual weights for the squared RGB distance
+    static int distance(const Color& a, const Color& b) {
+        int dr = a.r - b.r, dg = a.g - b.g, db = a.b - b.b;
+        return 2 * dr * dr + 4 * dg * dg + 3 * db * db;
+    }
+
+    explicit PaletteLUT(ColorMode mode) : table(32 * 32 * 32), spread(mode == ColorMode::ANSI16 ? 96 : 40) {
+        static const uint8_t cube[6] = {0, 95, 135, 175, 215, 255};
+        for (int i = 0; i < 32 * 32 * 32; i++) {
+            Color c(static_cast<uint8_t>((i >> 10) * 8 + 4), static_cast<uint8_t>((i >> 5 & 31) * 8 + 4),
+                    static_cast<uint8_t>((i & 31) * 8 + 4));
+            int best = 0, best_distance = INT32_MAX;
+            auto consider = [&](int index) {
+                int d = distance(c, palette_color(index));
+                if (d < best_distance) {
+                    best_distance = d;
+                    best = index;
+                }
+            };
+            if (mode == ColorMode::ANSI16) {
+                for (int index = 0; index < 16; index++) consider(index);
+            } else {
+                // Entries 0-15 are often themed, so only the color cube and
+                // the gray ramp are used. The distance is separable, so the
+                // nearest cube entry is the nearest level per channel.
+                auto level = [](uint8_t v) {
+                    int l = 0;
+                    for (int k = 1; k < 6; k++) {
+                        if (std::abs(cube[k] - v) < std::abs(cube[l] - v)) l = k;
+                    }
+                    return l;
+                };
+                consider(16 + level(c.r) * 36 + level(c.g) * 6 + level(c.b));
+                for (int index = 232; index < 256; index++) consider(index);
+            }
+            table[i] = static_cast<uint8_t>(best);
+        }
+    }
+};
@@ -0,0 +1,300 @@
+#pragma once
+
+#include <cstdio>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX  // Prevent windows.h from defining min/max macros
+#include <conio.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#include <termios.h>
+#include <fcntl.h>
+#include <poll.h>
+#endif
+
+// ============================================================================
+// Platform-specific keyboard input
+// ============================================================================
+//
+// The terminal is switched to raw mode once by enable_raw_input() and
+// restored at exit or on a fatal signal. Each frame, read_input() drains all
+// pending bytes in one go and KeyDecoder turns them into key events, so
+// polling input costs a single read() however many keys are queued.
+
+// Key codes for keys that are not a single byte; plain keys use their byte
+enum Key : int {
+    KEY_UP = 0x100,
+    KEY_DOWN,
+    KEY_RIGHT,
+    KEY_LEFT,
+};
+
+#ifdef _WIN32
+inline const char* volatile signal_exit_sequence = "";
+inline volatile std::sig_atomic_t exit_requested = 0;
+
+inline void enable_raw_input() {}
+inline void restore_terminal() {}
+
+// Windows: Ctrl+C sets exit_requested; the CRT then restores the default
+// handler, so a second Ctrl+C exits at once
+inline void watch_exit_signals() {
+    for (int sig : {SIGINT, SIGTERM}) {
+        signal(sig, [](int) { exit_requested = 1; });
+    }
+}
+
+// Windows: _getch() reports arrows as a 0/224 prefix plus a scan code; they
+// are translated to the VT sequences a Unix terminal would send
+inline void read_input(std::string& bytes) {
+    while (_kbhit()) {
+        int ch = _getch();
+        if (ch == 0 || ch == 224) {
+            switch (_getch()) {
+                case 72: bytes += "\033[A"; break;
+                case 80: bytes += "\033[B"; break;
+                case 77: bytes += "\033[C"; break;
+                case 75: bytes += "\033[D"; break;
+            }
+        } else {
+            bytes += static_cast<char>(ch);
+        }
+    }
+}
+
+// Windows: wait up to `timeout_ms` for input; true if some is pending
+inline bool wait_for_input(int timeout_ms) {
+    for (int waited = 0; !_kbhit(); waited += 10) {
+        if (waited >= timeout_ms) return false;
+        Sleep(10);
+    }
+    return true;
+}
+
+// Windows: the console does not report its font size
+inline void get_terminal_cell_size(int& width, int& height) {
+    width = 10;
+    height = 20;
+}
+
+// Windows: there is no resize signal, so the caller compares sizes every frame
+inline void watch_terminal_resize() {}
+inline bool terminal_resized() { return true; }
+
+// Windows: Get terminal window size (columns, rows)
+inline void get_terminal_size(int& width, int& height) {
+    CONSOLE_SCREEN_BUFFER_INFO csbi;
+    HANDLE hOut = GetStdHandle(STD_OUTPUT_HANDLE);
+    if (GetConsoleScreenBufferInfo(hOut, &csbi)) {
+        width = csbi.srWindow.Right - csbi.srWindow.Left + 1;
+        height = csbi.srWindow.Bottom - csbi.srWindow.Top + 1;
+    } else {
+        width = 120;   // Default fallback
+        height = 30;
+    }
+}
+#else
+inline struct termios saved_termios;
+inline volatile std::sig_atomic_t raw_input_enabled = 0;
+
+// Unix/Linux: put the original terminal mode back; safe in a signal handler
+inline void restore_terminal() {
+    if (!raw_input_enabled) return;
+    raw_input_enabled = 0;
+    tcsetattr(STDIN_FILENO, TCSANOW, &saved_termios);
+}
+
+// Extra output for restore_terminal_on_signal(), e.g. to remove images
+inline const char* volatile signal_exit_sequence = "";
+
+// Ctrl+C is the usual way out of the viewer, so besides the terminal mode
+// this also shows the cursor again before the signal terminates the process
+inline void restore_terminal_on_signal(int sig) {
+    restore_terminal();
+    const char reset[] = "\033[?25h\033[0m\n";
+    const char* extra = signal_exit_sequence;
+    ssize_t ignored = write(STDOUT_FILENO, extra, strlen(extra));
+    ignored = write(STDOUT_FILENO, reset, sizeof(reset) - 1);
+    (void)ignored;
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
+
+// Set by watch_exit_signals(): the viewer loop polls it and exits normally,
+// so recordings and captures are finished before the process ends
+inline volatile std::sig_atomic_t exit_requested = 0;
+
+// Unix/Linux: SIGINT/SIGTERM ask the viewer to exit; a second one (the viewer
+// is stuck) restores the terminal and terminates right away. Install before
+// enable_raw_input(), which keeps handlers that are already in place.
+inline void watch_exit_signals() {
+    for (int sig : {SIGINT, SIGTERM}) {
+        struct sigaction sa = {};
+        sa.sa_handler = [](int s) {
+            if (exit_requested) restore_terminal_on_signal(s);
+            exit_requested = 1;
+        };
+        sigaction(sig, &sa, nullptr);
+    }
+}
+
+// Unix/Linux: no line buffering or echo, and read() returns immediately when
+// nothing is pending (VMIN = VTIME = 0). Signals keep working (ISIG).
+inline void enable_raw_input() {
+    if (raw_input_enabled || tcgetattr(STDIN_FILENO, &saved_termios) != 0) return;
+    struct termios raw = saved_termios;
+    raw.c_lflag &= ~(ICANON | ECHO);
+    raw.c_cc[VMIN] = 0;
+    raw.c_cc[VTIME] = 0;
+    if (tcsetattr(STDIN_FILENO, TCSANOW, &raw) != 0) return;
+    raw_input_enabled = 1;
+
+    static bool handlers_installed = false;
+    if (handlers_installed) return;
+    handlers_installed = true;
+    atexit(restore_terminal);
+    for (int sig : {SIGINT, SIGTERM, SIGHUP, SIGQUIT}) {
+        struct sigaction sa = {};
+        sigaction(sig, nullptr, &sa);
+        if (sa.sa_handler != SIG_DFL) continue;  // Keep handlers installed by the caller
+        sa.sa_handler = restore_terminal_on_signal;
+        sigaction(sig, &sa, nullptr);
+    }
+}
+
+// Unix/Linux: append all pending input to `bytes` without blocking
+inline void read_input(std::string& bytes) {
+    char buf[256];
+    while (true) {
+        // Outside raw mode (stdin is a pipe or file) read() could block
+        if (!raw_input_enabled) {
+            pollfd pfd = {STDIN_FILENO, POLLIN, 0};
+            if (poll(&pfd, 1, 0) <= 0 || !(pfd.revents & POLLIN)) return;
+        }
+        ssize_t n = read(STDIN_FILENO, buf, sizeof(buf));
+        if (n <= 0) return;
+        bytes.append(buf, n);
+        if (n < static_cast<ssize_t>(sizeof(buf))) return;
+    }
+}
+
+// Unix/Linux: wait up to `timeout_ms` for input; true if some is pending
+inline bool wait_for_input(int timeout_ms) {
+    pollfd pfd = {STDIN_FILENO, POLLIN, 0};
+    return poll(&pfd, 1, timeout_ms) > 0 && (pfd.revents & POLLIN);
+}
+
+// Unix/Linux: SIGWINCH sets a flag, so the size is only queried after the
+// terminal actually changed instead of with an ioctl every frame
+inline volatile std::sig_atomic_t terminal_resize_pending = 1;
+
+inline void watch_terminal_resize() {
+    struct sigaction sa = {};
+    sa.sa_handler = [](int) { terminal_resize_pending = 1; };
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGWINCH, &sa, nullptr);
+}
+
+// True on the first call and once after every resize
+inline bool terminal_resized() {
+    if (!terminal_resize_pending) return false;
+    terminal_resize_pending = 0;    // Cleared before the size is read, so no resize is lost
+    return true;
+}
+
+// Unix/Linux: Get terminal window size (columns, rows)
+#include <sys/ioctl.h>
+inline void get_terminal_size(int& width, int& height) {
+    struct winsize ws;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0) {
+        width = ws.ws_col;
+        height = ws.ws_row;
+    } else {
+        width = 120;   // Default fallback
+        height = 30;
+    }
+}
+
+// Unix/Linux: size of one character cell in screen pixels, for graphics
+// output; terminals that do not report it get a typical 10x20
+inline void get_terminal_cell_size(int& width, int& height) {
+    struct winsize ws;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_xpixel > 0 && ws.ws_ypixel > 0 &&
+        ws.ws_col > 0 && ws.ws_row > 0) {
+        width = ws.ws_xpixel / ws.ws_col;
+        height = ws.ws_ypixel / ws.ws_row;
+    } else {
+        width = 10;
+        height = 20;
+    }
+}
+#endif
+
+// Turns terminal input bytes into key events. Arrow keys arrive as escape
+// sequences (ESC [ A, or ESC O A in application mode) that may be split
+// across reads, so an incomplete sequence is held until the next call.
+// Other escape sequences (function keys, terminal replies) are dropped.
+class KeyDecoder {
+public:
+    void decode(const char* data, size_t size, std::vector<int>& keys) {
+        pending.append(data, size);
+        size_t pos = 0;
+        while (pos < pending.size()) {
+            if (pending[pos] != '\033') {
+                keys.push_back(static_cast<unsigned char>(pending[pos++]));
+                continue;
+            }
+            size_t length = sequence_length(pos);
+            if (length == 0) break;  // Wait for the rest
+            if (length == 1) {
+                keys.push_back('\033');
+            } else if (length == 3) {
+                switch (pending[pos + 2]) {
+                    case 'A': keys.push_back(KEY_UP); break;
+                    case 'B': keys.push_back(KEY_DOWN); break;
+                    case 'C': keys.push_back(KEY_RIGHT); break;
+                    case 'D': keys.push_back(KEY_LEFT); break;
+                }
+            }
+            pos += length;
+        }
+        pending.erase(0, pos);
+    }
+
+    // Read and decode everything pending on stdin
+    void read(std::vector<int>& keys) {
+        buffer.clear();
+        read_input(buffer);
+        decode(buffer.data(), buffer.size(), keys);
+    }
+
+private:
+    std::string pending;    // Undecoded bytes
+    std::string buffer;
+
+    // Length of the escape sequence at `pos`: 1 for ESC followed by a plain
+    // key, 0 if incomplete (a trailing ESC waits for the next byte)
+    size_t sequence_length(size_t pos) const {
+        if (pos + 1 >= pending.size()) return 0;
+        char kind = pending[pos + 1];
+        if (kind == 'O') return pos + 2 < pending.size() ? 3 : 0;
+        if (kind == '_') {
+            // APC string up to ESC \, e.g. a kitty graphics reply
+            size_t end = pending.find("\033\\", pos + 2);
+            return end == std::string::npos ? 0 : end + 2 - pos;
+        }
+        if (kind != '[') return 1;
+        // CSI: parameter bytes, then a final byte in 0x40-0x7E
+        for (size_t i = pos + 2; i < pending.size(); i++) {
+            unsigned char c = static_cast<unsigned char>(pending[i]);
+            if (c >= 0x40 && c <= 0x7E) return i - pos + 1;
+        }
+        return 0;
+    }
+};
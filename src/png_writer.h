@@ -0,0 +1,361 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "parallel-util.hpp"
+
+// Implemented in stb_image_write.h (third_party.cpp); returns a zlib stream
+// to be released with free()
+extern "C" unsigned char* stbi_zlib_compress(unsigned char* data, int data_len, int* out_len, int quality);
+
+// ============================================================================
+// PNG writer - row bands filtered and compressed in parallel
+// ============================================================================
+//
+// A PNG holds a single zlib stream, so the bands are compressed
+// independently with stb's deflate and stitched together:
+// - every band but the last has its final-block bit cleared and is closed
+//   with an empty stored block, which byte-aligns the stream so the next
+//   band can follow directly
+// - matches never reach back across a band boundary, so each band decodes
+//   the same on its own and inside the whole stream
+// - the band checksums are combined into the checksum of the whole image
+// Each band becomes one IDAT chunk. Bands cost a little compression (each
+// starts with an empty window), so they are kept at 16 rows or more.
+
+namespace png_detail {
+
+inline uint32_t crc32(uint32_t crc, const uint8_t* data, size_t size) {
+    static const auto table = [] {
+        std::vector<uint32_t> t(256);
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            t[n] = c;
+        }
+        return t;
+    }();
+    crc = ~crc;
+    for (size_t i = 0; i < size; i++) crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+// Adler-32 of A followed by B, from the checksums of A and B
+inline uint32_t adler32_combine(uint32_t adler1, uint32_t adler2, size_t len2) {
+    const uint32_t BASE = 65521;
+    uint32_t rem = static_cast<uint32_t>(len2 % BASE);
+    uint32_t sum1 = adler1 & 0xFFFF;
+    uint32_t sum2 = static_cast<uint32_t>((static_cast<uint64_t>(rem) * sum1) % BASE);
+    sum1 += (adler2 & 0xFFFF) + BASE - 1;
+    sum2 += (adler1 >> 16) + (adler2 >> 16) + BASE - rem;
+    if (sum1 >= BASE) sum1 -= BASE;
+    if (sum1 >= BASE) sum1 -= BASE;
+    if (sum2 >= 2 * BASE) sum2 -= 2 * BASE;
+    if (sum2 >= BASE) sum2 -= BASE;
+    return sum1 | sum2 << 16;
+}
+
+// Bit position just past the end-of-block code of a deflate block with
+// fixed Huffman codes starting at bit 0 of `data`, or 0 if it is malformed
+inline size_t fixed_block_end(const uint8_t* data, size_t size) {
+    static const uint8_t length_extra[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2,
+                                             2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+    static const uint8_t distance_extra[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6,
+                                               6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+    // Literal/length decoding table indexed by the next 9 stream bits:
+    // symbol << 4 | code length
+    static const auto table = [] {
+        std::vector<uint16_t> t(512);
+        auto add = [&t](int symbol, uint32_t code, int length) {
+            uint32_t reversed = 0;
+            for (int i = 0; i < length; i++) reversed |= ((code >> i) & 1) << (length - 1 - i);
+            for (uint32_t fill = 0; fill < (1u << (9 - length)); fill++) {
+                t[reversed | fill << length] = static_cast<uint16_t>(symbol << 4 | length);
+            }
+        };
+        for (int s = 0; s < 144; s++) add(s, 0x30 + s, 8);
+        for (int s = 144; s < 256; s++) add(s, 0x190 + s - 144, 9);
+        for (int s = 256; s < 280; s++) add(s, s - 256, 7);
+        for (int s = 280; s < 288; s++) add(s, 0xC0 + s - 280, 8);
+        return t;
+    }();
+
+    size_t bit = 3;     // BFINAL, BTYPE
+    size_t total = size * 8;
+    auto peek = [&](int count) {
+        uint32_t v = 0;
+        for (int i = 0; i < count && bit + i < total; i++) {
+            v |= static_cast<uint32_t>((data[(bit + i) >> 3] >> ((bit + i) & 7)) & 1) << i;
+        }
+        return v;
+    };
+    auto get = [&](int count) {
+        uint32_t v = peek(count);
+        bit += count;
+        return v;
+    };
+    while (bit < total) {
+        uint16_t entry = table[peek(9)];
+        int symbol = entry >> 4;
+        bit += entry & 15;
+        if (symbol == 256) return bit <= total ? bit : 0;
+        if (symbol > 256) {
+            if (symbol > 285) return 0;
+            get(length_extra[symbol - 257]);
+            uint32_t code = get(5);
+            uint32_t distance = 0;
+            for (int i = 0; i < 5; i++) distance |= ((code >> i) & 1) << (4 - i);  // Huffman codes are MSB first
+            if (distance > 29) return 0;
+            get(distance_extra[distance]);
+        }
+    }
+    return 0;
+}
+
+inline void put_u32_be(std::vector<uint8_t>& out, uint32_t v) {
+    for (int i = 3; i >= 0; i--) out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+}
+
+// Append a chunk with its length, type, payload and CRC
+inline void append_chunk(std::vector<uint8_t>& out, const char* type, const uint8_t* payload, size_t size) {
+    put_u32_be(out, static_cast<uint32_t>(size));
+    size_t start = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), payload, payload + size);
+    put_u32_be(out, crc32(0, out.data() + start, size + 4));
+}
+
+inline uint8_t paeth(int a, int b, int c) {
+    int p = a + b - c, pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) return static_cast<uint8_t>(a);
+    return static_cast<uint8_t>(pb <= pc ? b : c);
+}
+
+// Filter row `y` into `out` (filter byte first) with the filter whose output
+// has the smallest sum of absolute values, as stb does
+inline void filter_row(const uint8_t* rgb, int width, int y, uint8_t* out, std::vector<uint8_t>& scratch) {
+    const int row_bytes = width * 3;
+    const uint8_t* row = rgb + static_cast<size_t>(y) * row_bytes;
+    const uint8_t* prior = y > 0 ? row - row_bytes : nullptr;     // Row -1 is zeros
+    scratch.resize(row_bytes);
+    int best_sum = INT32_MAX;
+    for (int filter = 0; filter < 5; filter++) {
+        uint8_t* f = scratch.data();
+        if (filter == 0) {
+            memcpy(f, row, row_bytes);
+        } else if (filter == 1) {
+            for (int i = 0; i < row_bytes; i++) f[i] = static_cast<uint8_t>(row[i] - (i >= 3 ? row[i - 3] : 0));
+        } else if (!prior) {
+            // Without a prior row, up is none and paeth is sub
+            if (filter != 3) continue;
+            for (int i = 0; i < row_bytes; i++) f[i] = static_cast<uint8_t>(row[i] - (i >= 3 ? row[i - 3] >> 1 : 0));
+        } else if (filter == 2) {
+            for (int i = 0; i < row_bytes; i++) f[i] = static_cast<uint8_t>(row[i] - prior[i]);
+        } else if (filter == 3) {
+            for (int i = 0; i < 3; i++) f[i] = static_cast<uint8_t>(row[i] - (prior[i] >> 1));
+            for (int i = 3; i < row_bytes; i++) f[i] = static_cast<uint8_t>(row[i] - ((row[i - 3] + prior[i]) >> 1));
+        } else {
+            for (int i = 0; i < 3; i++) f[i] = static_cast<uint8_t>(row[i] - prior[i]);
+            for (int i = 3; i < row_bytes; i++) f[i] = static_cast<uint8_t>(row[i] - paeth(row[i - 3], prior[i], prior[i - 3]));
+        }
+        int sum = 0;
+        for (int i = 0; i < row_bytes; i++) sum += std::abs(static_cast<int8_t>(f[i]));
+        if (sum < best_sum) {
+            best_sum = sum;
+            out[0] = static_cast<uint8_t>(filter);
+            memcpy(out + 1, f, row_bytes);
+        }
+    }
+}
+
+}  // namespace png_detail
+
+// Encode packed RGB as PNG using up to `bands` threads (0 = hardware concurrency)
+inline bool write_png(const char* filename, int width, int height, const uint8_t* rgb, int bands = 0) {
+    using namespace png_detail;
+    if (width <= 0 || height <= 0) return false;
+    if (bands <= 0) bands = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    bands = std::clamp(height / 16, 1, bands);
+    const int row_bytes = width * 3 + 1;
+
+    struct Band {
+        std::vector<uint8_t> idat;  // Chunk payload: this band's part of the zlib stream
+        uint32_t adler = 0;
+        size_t filtered_size = 0;
+        bool ok = false;
+    };
+    std::vector<Band> parts(bands);
+    parallelutil::parallel_for(bands, [&](int b) {
+        int y0 = static_cast<int>(static_cast<int64_t>(height) * b / bands);
+        int y1 = static_cast<int>(static_cast<int64_t>(height) * (b + 1) / bands);
+        Band& band = parts[b];
+        std::vector<uint8_t> filtered(static_cast<size_t>(y1 - y0) * row_bytes), scratch;
+        for (int y = y0; y < y1; y++) {
+            filter_row(rgb, width, y, filtered.data() + static_cast<size_t>(y - y0) * row_bytes, scratch);
+        }
+        band.filtered_size = filtered.size();
+
+        int zlen = 0;
+        unsigned char* z = stbi_zlib_compress(filtered.data(), static_cast<int>(filtered.size()), &zlen, 8);
+        if (!z || zlen < 6) {
+            free(z);
+            return;
+        }
+        // zlib header (kept for the first band), deflate blocks, Adler-32
+        const uint8_t* deflate = z + 2;
+        size_t deflate_size = static_cast<size_t>(zlen) - 6;
+        band.adler = static_cast<uint32_t>(z[zlen - 4]) << 24 | static_cast<uint32_t>(z[zlen - 3]) << 16 |
+                     static_cast<uint32_t>(z[zlen - 2]) << 8 | z[zlen - 1];
+        if (b == 0) band.idat.assign(z, z + 2);
+        size_t start = band.idat.size();
+        if (b == bands - 1) {
+            band.idat.insert(band.idat.end(), deflate, deflate + deflate_size);
+        } else if ((deflate[0] & 6) == 2) {
+            // One fixed Huffman block: cut after its end-of-block code, then
+            // an empty stored block (header bits, pad to a byte, LEN, NLEN).
+            // stb pads the end-of-block with zero bits, which serve as the
+            // stored block header when three or more are left.
+            size_t end = fixed_block_end(deflate, deflate_size);
+            if (end == 0) {
+                free(z);
+                return;
+            }
+            band.idat.insert(band.idat.end(), deflate, deflate + (end + 7) / 8);
+            band.idat[start] &= 0xFE;
+            size_t free_bits = (8 - end % 8) % 8;
+            if (free_bits < 3) band.idat.push_back(0);
+            const uint8_t sync[4] = {0x00, 0x00, 0xFF, 0xFF};
+            band.idat.insert(band.idat.end(), sync, sync + 4);
+        } else {
+            // Stored blocks (stb's fallback for incompressible data) end on a
+            // byte boundary; only the last block's final bit has to go
+            band.idat.insert(band.idat.end(), deflate, deflate + deflate_size);
+            size_t pos = start, last = start;
+            while (pos + 5 <= band.idat.size()) {
+                last = pos;
+                pos += 5 + (band.idat[pos + 1] | band.idat[pos + 2] << 8);
+            }
+            band.idat[last] &= 0xFE;
+        }
+        free(z);
+        band.ok = true;
+    }, bands);
+
+    uint32_t adler = 1;
+    for (const Band& band : parts) {
+        if (!band.ok) return false;
+        adler = adler32_combine(adler, band.adler, band.filtered_size);
+    }
+    put_u32_be(parts.back().idat, adler);
+
+    FILE* f = fopen(filename, "wb");
+    if (!f) return false;
+    std::vector<uint8_t> out = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    uint8_t header[13] = {};
+    for (int i = 0; i < 4; i++) {
+        header[i] = static_cast<uint8_t>(width >> (24 - 8 * i));
+        header[4 + i] = static_cast<uint8_t>(height >> (24 - 8 * i));
+    }
+    header[8] = 8;      // Bit depth
+    header[9] = 2;      // Truecolor
+    append_chunk(out, "IHDR", header, sizeof(header));
+    bool ok = fwrite(out.data(), 1, out.size(), f) == out.size();
+    for (const Band& band : parts) {
+        out.clear();
+        append_chunk(out, "IDAT", band.idat.data(), band.idat.size());
+        ok = ok && fwrite(out.data(), 1, out.size(), f) == out.size();
+    }
+    out.clear();
+    append_chunk(out, "IEND", nullptr, 0);
+    ok = ok && fwrite(out.data(), 1, out.size(), f) == out.size();
+    return (fclose(f) == 0) && ok;
+}
+
+// ============================================================================
+// Screenshot writer - PNG encoding off the render thread
+// ============================================================================
+//
+// save() only copies the pixels; a background thread encodes and writes
+// them, and poll() reports finished files to the UI.
+
+class ScreenshotWriter {
+public:
+    ScreenshotWriter() = default;
+    ScreenshotWriter(const ScreenshotWriter&) = delete;
+    ScreenshotWriter& operator=(const ScreenshotWriter&) = delete;
+    ~ScreenshotWriter() { finish(); }
+
+    // Queue packed RGB pixels; false while too many screenshots are pending
+    bool save(std::string filename, int width, int height, std::vector<uint8_t> rgb) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (queue.size() >= MAX_QUEUED) return false;
+        if (!writer.joinable()) writer = std::thread([this] { writer_loop(); });
+        queue.push_back({std::move(filename), width, height, std::move(rgb)});
+        work_available.notify_one();
+        return true;
+    }
+
+    // Take the next finished screenshot, if any
+    bool poll(std::string& filename, bool& ok) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (finished.empty()) return false;
+        filename = std::move(finished.front().first);
+        ok = finished.front().second;
+        finished.pop_front();
+        return true;
+    }
+
+    // Write what is queued and stop the thread
+    void finish() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done = true;
+        }
+        work_available.notify_all();
+        if (writer.joinable()) writer.join();
+    }
+
+private:
+    struct Job {
+        std::string filename;
+        int width, height;
+        std::vector<uint8_t> rgb;
+    };
+
+    static constexpr size_t MAX_QUEUED = 4;
+
+    std::thread writer;
+    std::deque<Job> queue;
+    std::deque<std::pair<std::string, bool>> finished;
+    std::mutex mutex;
+    std::condition_variable work_available;
+    bool done = false;
+
+    void writer_loop() {
+        // The render loop keeps every core busy, so encode with a share of them
+        int bands = std::max(1, static_cast<int>(std::thread::hardware_concurrency()) / 2);
+        while (true) {
+            Job job;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                work_available.wait(lock, [this] { return done || !queue.empty(); });
+                if (queue.empty()) return;
+                job = std::move(queue.front());
+                queue.pop_front();
+            }
+            bool ok = write_png(job.filename.c_str(), job.width, job.height, job.rgb.data(), bands);
+            std::lock_guard<std::mutex> lock(mutex);
+            finished.emplace_back(std::move(job.filename), ok);
+        }
+    }
+};
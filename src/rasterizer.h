@@ -0,0 +1,688 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <cstdint>
+#include <atomic>
+#include <cstring>
+#include <span>
+
+#include "HandmadeMath.h"
+#include "parallel-util.hpp"
+#include "framebuffer.h"
+#include "texture.h"
+#include "mesh.h"
+#include "trace.h"
+
+// ============================================================================
+// Rasterizer - software triangle rasterization
+// ============================================================================
+
+// Per-frame wall-clock time of each pipeline stage, in milliseconds
+struct FrameTimings {
+    double clear = 0, vertex = 0, setup = 0, raster = 0, shade = 0, encode = 0, write = 0;
+    uint64_t triangles_visible = 0;
+
+    double total() const { return clear + vertex + setup + raster + shade + encode + write; }
+};
+
+// Why a triangle was rejected before rasterization
+enum CullReason {
+    CULL_NONE = 0,       // Visible, goes on to the raster stage
+    CULL_NEAR,           // A vertex is behind the camera
+    CULL_FRUSTUM,        // All vertices outside one frustum plane
+    CULL_OFFSCREEN,      // Screen-space bounds entirely off screen
+    CULL_SUBPIXEL,       // Bounds collapse to no pixel after clamping
+    CULL_DEGENERATE,     // Zero area
+    CULL_BACKFACE,       // Facing away from the camera
+    CULL_REUSED,         // Only covers tiles kept from the previous frame (see temporal.h)
+    CULL_REASON_COUNT
+};
+
+// Hot-path event counts for one frame. Workers accumulate into their own
+// copy (see Rasterizer::chunk_counters) and the copies are summed once per
+// frame, so counting costs no shared-memory traffic.
+struct PipelineCounters {
+    uint64_t instances_culled = 0;             // Draw items skipped for a view by their bounds
+    uint64_t triangles_submitted = 0;
+    uint64_t culled[CULL_REASON_COUNT] = {};   // culled[CULL_NONE] counts visible triangles
+    uint64_t pixels_tested = 0;                // Pixels in triangle bounding boxes
+    uint64_t pixels_covered = 0;               // Inside the triangle and the depth range
+    uint64_t pixels_alpha_clipped = 0;
+    uint64_t pixels_depth_failed = 0;
+    uint64_t pixels_shaded = 0;
+    uint64_t cas_retries = 0;                  // Lost compare-and-swap races in the depth test
+    uint64_t terminal_bytes = 0;               // Bytes written to the terminal
+
+    uint64_t triangles_culled() const {
+        uint64_t total = 0;
+        for (int i = CULL_NONE + 1; i < CULL_REASON_COUNT; i++) total += culled[i];
+        return total;
+    }
+
+    void add(const PipelineCounters& o) {
+        instances_culled += o.instances_culled;
+        triangles_submitted += o.triangles_submitted;
+        for (int i = 0; i < CULL_REASON_COUNT; i++) culled[i] += o.culled[i];
+        pixels_tested += o.pixels_tested;
+        pixels_covered += o.pixels_covered;
+        pixels_alpha_clipped += o.pixels_alpha_clipped;
+        pixels_depth_failed += o.pixels_depth_failed;
+        pixels_shaded += o.pixels_shaded;
+        cas_retries += o.cas_retries;
+        terminal_bytes += o.terminal_bytes;
+    }
+};
+
+// Milliseconds elapsed since `start`
+inline double elapsed_ms(std::chrono::high_resolution_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+// Number of worker threads parallel_for will use
+inline int worker_count() {
+    int hint = static_cast<int>(std::thread::hardware_concurrency());
+    return (hint == 0) ? 4 : hint;
+}
+
+// Split [0, n) into `num_chunks` contiguous ranges processed in parallel,
+// one per worker. Worker k records trace events on lane k + 1. Ranges have
+// the type of `n` (int, or size_t for totals over many draw passes).
+template<typename Index, typename Callable>
+void parallel_chunks(Index n, int num_chunks, Callable function) {
+    if (static_cast<uint64_t>(n) < static_cast<uint64_t>(num_chunks)) num_chunks = static_cast<int>(n);
+    num_chunks = std::max(1, num_chunks);
+    parallelutil::parallel_for(num_chunks, [&](int chunk) {
+        TraceLane lane(chunk + 1);
+        Index begin = static_cast<Index>(static_cast<uint64_t>(n) * chunk / num_chunks);
+        Index end = static_cast<Index>(static_cast<uint64_t>(n) * (chunk + 1) / num_chunks);
+        function(chunk, begin, end);
+    });
+}
+
+// Tiles of the framebuffer that set_reused_tiles() can exclude from rasterization
+constexpr int REUSE_TILE_SIZE = 8;
+constexpr int REUSE_TILE_SHIFT = 3;
+
+// Vertex after the vertex stage: clip position plus derived screen-space data
+struct TransformedVertex {
+    HMM_Vec4 clip;      // Clip-space position
+    HMM_Vec3 screen;    // Screen-space X/Y and NDC depth (valid only when clip.W > NEAR_W)
+    float inv_w;        // 1 / clip.W for perspective-correct interpolation
+    HMM_Vec2 texcoord;
+    HMM_Vec3 normal;    // View-space normal
+};
+
+// One camera's view drawn into a rectangle of the framebuffer
+struct Viewport {
+    int x = 0, y = 0, width = 0, height = 0;   // Pixel rectangle
+    HMM_Mat4 mvp;
+    HMM_Mat4 model_view;
+};
+
+// A mesh drawn with its own model transform, e.g. one instance of a scene
+// object. Instances of the same mesh share its vertex and index data.
+struct DrawItem {
+    const Mesh* mesh = nullptr;
+    const Texture* texture = nullptr;   // nullptr = the rasterizer's texture
+    const HMM_Mat4* model = nullptr;    // Applied before the view's matrices; nullptr = identity
+    const HMM_Vec3* bounds = nullptr;   // Object-space {min, max}; nullptr = never culled whole
+};
+
+// Rasterized surface attributes, lit later by the shade stage
+struct SurfaceSample {
+    Color albedo;       // albedo.a == 255 marks a pixel written since the last shade pass
+    HMM_Vec3 normal;    // Interpolated, not yet normalized
+};
+
+class Rasterizer {
+public:
+    Framebuffer& fb;
+    const Texture* texture = nullptr;
+    HMM_Vec3 light_dir;
+    
+    // Event counts of the most recent draw call (or accumulated by draw_triangle())
+    PipelineCounters counters;
+    
+    // Vertices closer than this to the camera plane are treated as behind it
+    static constexpr float NEAR_W = 0.001f;
+    
+    Rasterizer(Framebuffer& framebuffer) : fb(framebuffer) {
+        light_dir = HMM_NormV3(HMM_V3(0.5f, 1.0f, 0.8f));
+    }
+    
+    void set_texture(const Texture* tex) {
+        texture = tex;
+    }
+    
+    // Skip pixels in tiles whose `mask` entry is non-zero: they already hold
+    // valid color and depth. One entry per REUSE_TILE_SIZE square, row-major;
+    // nullptr rasterizes everything. The mask must outlive the draw calls.
+    void set_reused_tiles(const std::vector<uint8_t>* mask) {
+        reused_tiles = (mask && !mask->empty()) ? mask->data() : nullptr;
+        reuse_tiles_x = (fb.width + REUSE_TILE_SIZE - 1) >> REUSE_TILE_SHIFT;
+    }
+    
+    // Draw a single triangle with interpolated attributes
+    // Rasterized pixels are lit by the next call to shade(). Not thread-safe:
+    // events are counted directly into `counters`.
+    void draw_triangle(
+        const std::array<HMM_Vec4, 3>& clip_verts,
+        const std::array<HMM_Vec2, 3>& texcoords,
+        const std::array<HMM_Vec3, 3>& normals
+    ) {
+        ensure_surface();
+        Viewport full = {0, 0, fb.width, fb.height, HMM_M4D(1.0f), HMM_M4D(1.0f)};
+        std::array<TransformedVertex, 3> v;
+        for (int i = 0; i < 3; i++) {
+            v[i] = make_vertex(full, clip_verts[i], texcoords[i], normals[i]);
+        }
+        counters.triangles_submitted++;
+        CullReason reason = setup_triangle(full, v[0], v[1], v[2]);
+        counters.culled[reason]++;
+        if (reason == CULL_NONE) {
+            raster_triangle(full, texture, v[0], v[1], v[2], counters);
+        }
+    }
+    
+    // Draw all triangles of a mesh, then light the covered pixels.
+    // The work is split into vertex, setup (culling), raster and shade stages;
+    // when `timings` is given each stage's wall-clock time is recorded.
+    void draw_mesh(const Mesh& mesh, const HMM_Mat4& mvp, const HMM_Mat4& model_view,
+                   FrameTimings* timings = nullptr) {
+        Viewport full = {0, 0, fb.width, fb.height, mvp, model_view};
+        draw_views(mesh, {&full, 1}, timings);
+    }
+    
+    // Draw a mesh into several viewports (disjoint framebuffer rectangles)
+    void draw_views(const Mesh& mesh, std::span<const Viewport> views, FrameTimings* timings = nullptr) {
+        DrawItem item;
+        item.mesh = &mesh;
+        draw_items({&item, 1}, views, timings);
+    }
+    
+    // Draw meshes into several viewports (disjoint framebuffer rectangles).
+    // Each stage runs once for all viewports and items, so small views and
+    // small meshes share workers with large ones instead of each paying for
+    // its own pass and barrier. Items whose bounds are outside a view are
+    // dropped for it before their vertices are transformed. Viewports with
+    // the same matrices and size are transformed, culled and rasterized once,
+    // then copied.
+    void draw_items(std::span<const DrawItem> items, std::span<const Viewport> views,
+                    FrameTimings* timings = nullptr) {
+        ensure_surface();
+        auto stage_start = std::chrono::high_resolution_clock::now();
+        
+        // Find the distinct views; duplicates reuse the first one's pixels
+        unique_views.clear();
+        std::vector<std::pair<int, int>> copies;   // (source view, duplicate view)
+        for (int i = 0; i < static_cast<int>(views.size()); i++) {
+            int match = -1;
+            for (int u : unique_views) {
+                if (same_view(views[u], views[i])) {
+                    match = u;
+                    break;
+                }
+            }
+            if (match < 0) {
+                unique_views.push_back(i);
+            } else {
+                copies.emplace_back(match, i);
+            }
+        }
+        
+        // One pass per visible (view, item) pair, laid out back to back in
+        // the vertex and triangle ranges the stages split between workers
+        uint64_t instances_culled = 0;
+        passes.clear();
+        vertex_starts.assign(1, 0);
+        triangle_starts.assign(1, 0);
+        for (int u : unique_views) {
+            const Viewport& vp = views[u];
+            for (const DrawItem& item : items) {
+                Pass pass = {&vp, &item, vp.mvp, vp.model_view};
+                if (item.model) {
+                    pass.mvp = HMM_MulM4(vp.mvp, *item.model);
+                    pass.model_view = HMM_MulM4(vp.model_view, *item.model);
+                }
+                if (item.bounds && outside_frustum(pass.mvp, item.bounds[0], item.bounds[1])) {
+                    instances_culled++;
+                    continue;
+                }
+                passes.push_back(pass);
+                vertex_starts.push_back(vertex_starts.back() + item.mesh->vertices.size());
+                triangle_starts.push_back(triangle_starts.back() + item.mesh->indices.size() / 3);
+            }
+        }
+        
+        // Vertex stage: transform every vertex once per pass
+        size_t total_vertices = vertex_starts.back();
+        transformed.resize(total_vertices);
+        {
+            TRACE_SCOPE("vertex");
+            parallel_chunks(total_vertices, worker_count(), [&](int, size_t begin, size_t end) {
+                TRACE_SCOPE("vertex chunk");
+                for_each_pass(begin, end, vertex_starts, [&](int p, size_t first, size_t last) {
+                    const Pass& pass = passes[p];
+                    const Mesh& mesh = *pass.item->mesh;
+                    TransformedVertex* out = transformed.data() + vertex_starts[p];
+                    for (size_t i = first; i < last; i++) {
+                        const Vertex& v = mesh.vertices[i];
+                        HMM_Vec4 n = HMM_MulM4V4(pass.model_view, HMM_V4(v.normal.X, v.normal.Y, v.normal.Z, 0.0f));
+                        out[i] = make_vertex(*pass.view, HMM_MulM4V4(pass.mvp, HMM_V4(v.position.X, v.position.Y, v.position.Z, 1.0f)),
+                                             v.texcoord, HMM_V3(n.X, n.Y, n.Z));
+                    }
+                });
+            });
+        }
+        if (timings) timings->vertex = elapsed_ms(stage_start);
+        
+        // Setup stage: cull triangles, keeping survivors in per-chunk lists
+        // so each thread rasterizes the same contiguous range it culled
+        stage_start = std::chrono::high_resolution_clock::now();
+        size_t total_triangles = triangle_starts.back();
+        int num_chunks = static_cast<int>(std::clamp<size_t>(total_triangles, 1, worker_count()));
+        visible.resize(num_chunks);
+        chunk_counters.assign(num_chunks, PaddedCounters());
+        {
+            TRACE_SCOPE("setup");
+            parallel_chunks(total_triangles, num_chunks, [&](int chunk, size_t begin, size_t end) {
+                TRACE_SCOPE("setup chunk");
+                PipelineCounters& c = chunk_counters[chunk].counters;
+                VisibleList& list = visible[chunk];
+                list.triangles.clear();
+                list.pass_starts.clear();
+                for_each_pass(begin, end, triangle_starts, [&](int p, size_t first, size_t last) {
+                    list.pass_starts.emplace_back(p, list.triangles.size());
+                    const Pass& pass = passes[p];
+                    const unsigned int* indices = pass.item->mesh->indices.data();
+                    const TransformedVertex* tv = transformed.data() + vertex_starts[p];
+                    for (size_t t = first; t < last; t++) {
+                        const unsigned int* idx = &indices[t * 3];
+                        CullReason reason = setup_triangle(*pass.view, tv[idx[0]], tv[idx[1]], tv[idx[2]]);
+                        c.culled[reason]++;
+                        if (reason == CULL_NONE) {
+                            list.triangles.push_back(static_cast<uint32_t>(t));
+                        }
+                    }
+                });
+                c.triangles_submitted += end - begin;
+            });
+        }
+        if (timings) {
+            timings->setup = elapsed_ms(stage_start);
+            timings->triangles_visible = 0;
+            for (const auto& list : visible) timings->triangles_visible += list.triangles.size();
+        }
+        
+        // Raster stage: coverage, attribute interpolation, texturing, depth test
+        stage_start = std::chrono::high_resolution_clock::now();
+        {
+            TRACE_SCOPE("raster");
+            parallel_chunks(num_chunks, num_chunks, [&](int chunk, int, int) {
+                TRACE_SCOPE("raster chunk");
+                PipelineCounters& c = chunk_counters[chunk].counters;
+                const VisibleList& list = visible[chunk];
+                for (size_t s = 0; s < list.pass_starts.size(); s++) {
+                    auto [p, first] = list.pass_starts[s];
+                    size_t last = (s + 1 < list.pass_starts.size()) ? list.pass_starts[s + 1].second : list.triangles.size();
+                    const Pass& pass = passes[p];
+                    const unsigned int* indices = pass.item->mesh->indices.data();
+                    const Texture* tex = pass.item->texture ? pass.item->texture : texture;
+                    const TransformedVertex* tv = transformed.data() + vertex_starts[p];
+                    for (size_t i = first; i < last; i++) {
+                        const unsigned int* idx = &indices[static_cast<size_t>(list.triangles[i]) * 3];
+                        raster_triangle(*pass.view, tex, tv[idx[0]], tv[idx[1]], tv[idx[2]], c);
+                    }
+                }
+            });
+        }
+        if (timings) timings->raster = elapsed_ms(stage_start);
+        
+        counters = PipelineCounters();
+        counters.instances_culled = instances_culled;
+        for (const auto& c : chunk_counters) counters.add(c.counters);
+        
+        // Shade stage: light each visible pixel exactly once
+        stage_start = std::chrono::high_resolution_clock::now();
+        shade();
+        for (const auto& [from, to] : copies) copy_view(views[from], views[to]);
+        if (timings) timings->shade = elapsed_ms(stage_start);
+    }
+    
+    // Apply lighting to every pixel rasterized since the previous shade pass
+    void shade() {
+        TRACE_SCOPE("shade");
+        ensure_surface();
+        std::atomic<uint64_t> shaded{0};
+        parallel_chunks(fb.height, worker_count(), [&](int, int row_begin, int row_end) {
+            TRACE_SCOPE("shade chunk");
+            uint64_t chunk_shaded = 0;
+            for (int i = row_begin * fb.width; i < row_end * fb.width; i++) {
+                SurfaceSample& s = surface[i];
+                if (s.albedo.a != 255) continue;
+                s.albedo.a = 0;
+                chunk_shaded++;
+                
+                // Simple diffuse lighting
+                HMM_Vec3 normal = HMM_NormV3(s.normal);
+                float ndotl = std::max(0.0f, HMM_DotV3(normal, light_dir));
+                float ambient = 0.3f;
+                float diffuse = 0.7f * ndotl;
+                float lighting = ambient + diffuse;
+                
+                Color final_color = s.albedo * lighting;
+                final_color.a = 255;
+                fb.color_buffer[i] = final_color;
+            }
+            shaded.fetch_add(chunk_shaded, std::memory_order_relaxed);
+        });
+        counters.pixels_shaded += shaded.load();
+    }
+    
+private:
+    // One cache line per worker so counter updates never share a line
+    struct alignas(64) PaddedCounters {
+        PipelineCounters counters;
+    };
+    
+    // One item drawn into one distinct view
+    struct Pass {
+        const Viewport* view;
+        const DrawItem* item;
+        HMM_Mat4 mvp, model_view;
+    };
+    
+    // Triangles of one chunk that survived setup, grouped by pass
+    struct VisibleList {
+        std::vector<uint32_t> triangles;  // Within the pass's mesh (indices are 32-bit)
+        std::vector<std::pair<int, size_t>> pass_starts;   // (pass, first index into triangles)
+    };
+    
+    std::vector<TransformedVertex> transformed;    // Passes back to back
+    std::vector<int> unique_views;
+    std::vector<Pass> passes;
+    std::vector<size_t> vertex_starts;  // Prefix sums over passes, one extra entry at the end
+    std::vector<size_t> triangle_starts;
+    std::vector<VisibleList> visible;
+    std::vector<PaddedCounters> chunk_counters;
+    std::vector<SurfaceSample> surface;
+    const uint8_t* reused_tiles = nullptr;
+    int reuse_tiles_x = 0;
+    
+    void ensure_surface() {
+        size_t size = static_cast<size_t>(fb.width) * fb.height;
+        if (surface.size() != size) surface.assign(size, SurfaceSample{Color(0, 0, 0, 0), HMM_V3(0, 0, 0)});
+    }
+    
+    // Split the range [begin, end) over concatenated per-pass arrays starting
+    // at `starts` into per-pass pieces: fn(pass, first, last)
+    template<typename Callable>
+    static void for_each_pass(size_t begin, size_t end, const std::vector<size_t>& starts, Callable fn) {
+        int pass = static_cast<int>(std::upper_bound(starts.begin(), starts.end(), begin) - starts.begin()) - 1;
+        for (; pass + 1 < static_cast<int>(starts.size()) && starts[pass] < end; pass++) {
+            size_t first = std::max(begin, starts[pass]), last = std::min(end, starts[pass + 1]);
+            if (first < last) fn(pass, first - starts[pass], last - starts[pass]);
+        }
+    }
+    
+    // True if the box is entirely outside one clip plane of `mvp`
+    static bool outside_frustum(const HMM_Mat4& mvp, const HMM_Vec3& lo, const HMM_Vec3& hi) {
+        int outside[6] = {};
+        for (int corner = 0; corner < 8; corner++) {
+            HMM_Vec4 p = HMM_MulM4V4(mvp, HMM_V4((corner & 1) ? hi.X : lo.X, (corner & 2) ? hi.Y : lo.Y,
+                                                 (corner & 4) ? hi.Z : lo.Z, 1.0f));
+            outside[0] += p.X < -p.W;
+            outside[1] += p.X > p.W;
+            outside[2] += p.Y < -p.W;
+            outside[3] += p.Y > p.W;
+            outside[4] += p.Z < -p.W;
+            outside[5] += p.Z > p.W;
+        }
+        for (int plane = 0; plane < 6; plane++) {
+            if (outside[plane] == 8) return true;
+        }
+        return false;
+    }
+    
+    static bool same_view(const Viewport& a, const Viewport& b) {
+        return a.width == b.width && a.height == b.height &&
+               memcmp(&a.mvp, &b.mvp, sizeof(HMM_Mat4)) == 0 &&
+               memcmp(&a.model_view, &b.model_view, sizeof(HMM_Mat4)) == 0;
+    }
+    
+    // Copy a finished view's color and depth into an identical viewport
+    void copy_view(const Viewport& from, const Viewport& to) {
+        for (int row = 0; row < from.height; row++) {
+            size_t src = static_cast<size_t>(from.y + row) * fb.width + from.x;
+            size_t dst = static_cast<size_t>(to.y + row) * fb.width + to.x;
+            std::copy_n(fb.color_buffer.begin() + src, from.width, fb.color_buffer.begin() + dst);
+            for (int i = 0; i < from.width; i++) {
+                fb.depth_buffer[dst + i].store(fb.depth_buffer[src + i].load(std::memory_order_relaxed),
+                                               std::memory_order_relaxed);
+            }
+        }
+    }
+    
+    TransformedVertex make_vertex(const Viewport& vp, const HMM_Vec4& clip, const HMM_Vec2& texcoord,
+                                  const HMM_Vec3& normal) const {
+        TransformedVertex out;
+        out.clip = clip;
+        out.texcoord = texcoord;
+        out.normal = normal;
+        out.inv_w = 0.0f;
+        out.screen = HMM_V3(0, 0, 0);
+        
+        // Perspective divide - only meaningful in front of the camera
+        if (clip.W > NEAR_W) {
+            out.inv_w = 1.0f / clip.W;
+            float x = clip.X * out.inv_w;
+            float y = clip.Y * out.inv_w;
+            
+            // NDC to screen space
+            out.screen.X = vp.x + (x + 1.0f) * 0.5f * vp.width;
+            out.screen.Y = vp.y + (1.0f - y) * 0.5f * vp.height;  // Flip Y
+            out.screen.Z = clip.Z * out.inv_w;
+        }
+        return out;
+    }
+    
+    // Edge function for barycentric coordinates
+    static float edge(const HMM_Vec3& a, const HMM_Vec3& b, float px, float py) {
+        return (px - a.X) * (b.Y - a.Y) - (py - a.Y) * (b.X - a.X);
+    }
+    
+    // Frustum, screen-bounds, sub-pixel, degenerate and backface culling.
+    // Returns CULL_NONE if the triangle may cover pixels.
+    CullReason setup_triangle(const Viewport& vp, const TransformedVertex& v0, const TransformedVertex& v1,
+                              const TransformedVertex& v2) const {
+        const TransformedVertex* v[3] = {&v0, &v1, &v2};
+        
+        // ================================================================
+        // Frustum Culling in Clip Space (before perspective divide)
+        // ================================================================
+        
+        // Near plane culling: check if any vertex is behind camera
+        for (int i = 0; i < 3; i++) {
+            if (v[i]->clip.W <= NEAR_W) return CULL_NEAR;  // Vertex behind camera
+        }
+        
+        // Frustum plane culling: check if all vertices are outside the same plane
+        // A vertex is outside if: coord > W (right/top/far) or coord < -W (left/bottom/near)
+        int all_left = 0, all_right = 0, all_bottom = 0, all_top = 0, all_near = 0, all_far = 0;
+        
+        for (int i = 0; i < 3; i++) {
+            float x = v[i]->clip.X;
+            float y = v[i]->clip.Y;
+            float z = v[i]->clip.Z;
+            float w = v[i]->clip.W;
+            
+            if (x < -w) all_left++;
+            if (x >  w) all_right++;
+            if (y < -w) all_bottom++;
+            if (y >  w) all_top++;
+            if (z < -w) all_near++;
+            if (z >  w) all_far++;
+        }
+        
+        // If all 3 vertices are outside the same frustum plane, cull the triangle
+        if (all_left == 3 || all_right == 3 || 
+            all_bottom == 3 || all_top == 3 ||
+            all_near == 3 || all_far == 3) {
+            return CULL_FRUSTUM;
+        }
+        
+        // ================================================================
+        // Screen Space Culling
+        // ================================================================
+        
+        // Compute bounding box
+        float min_x = std::min({v0.screen.X, v1.screen.X, v2.screen.X});
+        float max_x = std::max({v0.screen.X, v1.screen.X, v2.screen.X});
+        float min_y = std::min({v0.screen.Y, v1.screen.Y, v2.screen.Y});
+        float max_y = std::max({v0.screen.Y, v1.screen.Y, v2.screen.Y});
+        
+        // Screen bounds culling - triangle completely outside the viewport
+        if (max_x < vp.x || min_x >= vp.x + vp.width || max_y < vp.y || min_y >= vp.y + vp.height) {
+            return CULL_OFFSCREEN;
+        }
+        
+        // Sub-pixel triangle culling
+        int x0 = std::max(vp.x, static_cast<int>(std::floor(min_x)));
+        int x1 = std::min(vp.x + vp.width - 1, static_cast<int>(std::ceil(max_x)));
+        int y0 = std::max(vp.y, static_cast<int>(std::floor(min_y)));
+        int y1 = std::min(vp.y + vp.height - 1, static_cast<int>(std::ceil(max_y)));
+        if (x0 > x1 || y0 > y1) return CULL_SUBPIXEL;
+        
+        // ================================================================
+        // Area and Backface Culling
+        // ================================================================
+        
+        float area = edge(v0.screen, v1.screen, v2.screen.X, v2.screen.Y);
+        
+        // Degenerate triangle culling (zero area)
+        if (std::abs(area) < 0.001f) return CULL_DEGENERATE;
+        
+        // Backface culling: positive area = clockwise winding = back face
+        // (In screen space with Y flipped, CCW triangles have negative area)
+        if (area < 0) return CULL_BACKFACE;
+        
+        // Nothing to do if every tile under the bounds is reused
+        if (reused_tiles) {
+            for (int ty = y0 >> REUSE_TILE_SHIFT; ty <= y1 >> REUSE_TILE_SHIFT; ty++) {
+                for (int tx = x0 >> REUSE_TILE_SHIFT; tx <= x1 >> REUSE_TILE_SHIFT; tx++) {
+                    if (!reused_tiles[ty * reuse_tiles_x + tx]) return CULL_NONE;
+                }
+            }
+            return CULL_REUSED;
+        }
+        
+        return CULL_NONE;
+    }
+    
+    // Rasterize a triangle that passed setup into the surface buffer
+    void raster_triangle(const Viewport& vp, const Texture* tex, const TransformedVertex& v0, const TransformedVertex& v1,
+                         const TransformedVertex& v2, PipelineCounters& c) {
+        const HMM_Vec3& s0 = v0.screen;
+        const HMM_Vec3& s1 = v1.screen;
+        const HMM_Vec3& s2 = v2.screen;
+        
+        int x0 = std::max(vp.x, static_cast<int>(std::floor(std::min({s0.X, s1.X, s2.X}))));
+        int x1 = std::min(vp.x + vp.width - 1, static_cast<int>(std::ceil(std::max({s0.X, s1.X, s2.X}))));
+        int y0 = std::max(vp.y, static_cast<int>(std::floor(std::min({s0.Y, s1.Y, s2.Y}))));
+        int y1 = std::min(vp.y + vp.height - 1, static_cast<int>(std::ceil(std::max({s0.Y, s1.Y, s2.Y}))));
+        
+        float inv_area = 1.0f / edge(s0, s1, s2.X, s2.Y);
+        
+        // Local tallies keep the inner loop free of stores to `c`
+        uint32_t covered = 0, alpha_clipped = 0, depth_failed = 0, cas_retries = 0;
+        
+        for (int y = y0; y <= y1; y++) {
+            const uint8_t* reused_row = reused_tiles ? reused_tiles + (y >> REUSE_TILE_SHIFT) * reuse_tiles_x : nullptr;
+            for (int x = x0; x <= x1; x++) {
+                if (reused_row && reused_row[x >> REUSE_TILE_SHIFT]) continue;
+                float px = x + 0.5f;
+                float py = y + 0.5f;
+                
+                float w0 = edge(s1, s2, px, py);
+                float w1 = edge(s2, s0, px, py);
+                float w2 = edge(s0, s1, px, py);
+                
+                // Check if inside triangle (allow for both winding orders)
+                bool inside = (w0 >= 0 && w1 >= 0 && w2 >= 0) || (w0 <= 0 && w1 <= 0 && w2 <= 0);
+                if (!inside) continue;
+                
+                // Barycentric coordinates
+                w0 *= inv_area;
+                w1 *= inv_area;
+                w2 *= inv_area;
+                
+                // Interpolate depth
+                float depth = w0 * s0.Z + w1 * s1.Z + w2 * s2.Z;
+                
+                // Depth test
+                if (depth < -1.0f || depth > 1.0f) continue;
+                covered++;
+                
+                // Perspective-correct interpolation
+                float p0 = w0 * v0.inv_w;
+                float p1 = w1 * v1.inv_w;
+                float p2 = w2 * v2.inv_w;
+                float corr = 1.0f / (p0 + p1 + p2);
+                p0 *= corr;
+                p1 *= corr;
+                p2 *= corr;
+                
+                // Interpolate texcoords
+                float u = p0 * v0.texcoord.X + p1 * v1.texcoord.X + p2 * v2.texcoord.X;
+                float v = p0 * v0.texcoord.Y + p1 * v1.texcoord.Y + p2 * v2.texcoord.Y;
+                
+                // Sample texture
+                Color base_color = tex ? tex->sample(u, v) : Color(200, 200, 200, 255);
+                
+                // Alpha clip: skip pixels with alpha < 0.1 (alpha test)
+                if (base_color.should_clip(0.1f)) {
+                    alpha_clipped++;
+                    continue;
+                }
+                
+                int idx = y * fb.width + x;
+                if (!fb.depth_test(idx, depth, cas_retries)) {
+                    depth_failed++;
+                    continue;
+                }
+                
+                // Won the depth test: record attributes for the shade stage
+                SurfaceSample& s = surface[idx];
+                s.albedo = Color(base_color.r, base_color.g, base_color.b, 255);
+                s.normal.X = p0 * v0.normal.X + p1 * v1.normal.X + p2 * v2.normal.X;
+                s.normal.Y = p0 * v0.normal.Y + p1 * v1.normal.Y + p2 * v2.normal.Y;
+                s.normal.Z = p0 * v0.normal.Z + p1 * v1.normal.Z + p2 * v2.normal.Z;
+            }
+        }
+        
+        c.pixels_tested += static_cast<uint64_t>(x1 - x0 + 1) * (y1 - y0 + 1);
+        c.pixels_covered += covered;
+        c.pixels_alpha_clipped += alpha_clipped;
+        c.pixels_depth_failed += depth_failed;
+        c.cas_retries += cas_retries;
+    }
+};
+
+// Build model matrix: center mesh and scale to unit size (no rotation - camera orbits instead)
+inline HMM_Mat4 make_model_matrix(const HMM_Vec3& center, float scale) {
+    HMM_Mat4 model = HMM_M4D(1.0f);
+    model = HMM_MulM4(model, HMM_Scale(HMM_V3(2.0f / scale, 2.0f / scale, 2.0f / scale)));
+    model = HMM_MulM4(model, HMM_Translate(HMM_V3(-center.X, -center.Y, -center.Z)));
+    return model;
+}
+
+// Perspective projection for a render target of the given pixel size
+inline HMM_Mat4 make_projection(int w, int h) {
+    float aspect = static_cast<float>(w) / h;
+    return HMM_Perspective_RH_NO(HMM_AngleDeg(45.0f), aspect, 0.1f, 100.0f);
+}
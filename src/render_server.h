@@ -0,0 +1,315 @@
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "platform.h"
+#include "framebuffer.h"
+#include "texture.h"
+#include "mesh.h"
+#include "rasterizer.h"
+#include "scene.h"
+#include "terminal_renderer.h"
+#include "camera.h"
+#include "trace.h"
+
+// ============================================================================
+// Render server - one process serves many terminal viewers over a socket
+// ============================================================================
+//
+// The server loads the scene once and listens on a Unix domain socket. Each
+// connected client has its own camera and terminal size; frames are rendered
+// one at a time on the shared pipeline (so every frame still uses all cores
+// without oversubscribing them) and streamed back as terminal escape codes.
+//
+// Client -> server messages are [type:1][length:1][payload:length]:
+//   'S'  terminal size: cols (uint16 LE), rows (uint16 LE)
+//   'K'  raw terminal input bytes, decoded by the server (arrow keys are
+//        escape sequences that may span messages)
+// Server -> client is the raw terminal byte stream.
+
+#ifndef _WIN32
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+constexpr uint8_t MSG_SIZE = 'S';
+constexpr uint8_t MSG_KEYS = 'K';
+constexpr int SERVER_STATUS_ROWS = 3;  // Blank separator line plus two status lines
+
+inline volatile std::sig_atomic_t server_stop_requested = 0;
+
+inline bool set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+inline bool make_socket_address(const char* path, sockaddr_un& addr) {
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        std::cerr << "Socket path too long: " << path << std::endl;
+        return false;
+    }
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    return true;
+}
+
+class RenderServer {
+public:
+    RenderServer(const Scene& scene, const Texture& texture)
+        : scene(scene), fb(1, 1), rasterizer(fb) {
+        rasterizer.set_texture(&texture);
+        HMM_Vec3 center;
+        float scale;
+        scene.get_bounds(center, scale);
+        model = make_model_matrix(center, scale);
+    }
+
+    // Serve until SIGINT/SIGTERM; returns a process exit code
+    int run(const char* socket_path) {
+        sockaddr_un addr;
+        if (!make_socket_address(socket_path, addr)) return 1;
+
+        listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        unlink(socket_path);
+        if (listen_fd < 0 || bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 ||
+            listen(listen_fd, 16) != 0 || !set_nonblocking(listen_fd)) {
+            std::cerr << "Failed to listen on " << socket_path << ": " << strerror(errno) << std::endl;
+            return 1;
+        }
+
+        struct sigaction sa = {};
+        sa.sa_handler = [](int) { server_stop_requested = 1; };
+        sigaction(SIGINT, &sa, nullptr);
+        sigaction(SIGTERM, &sa, nullptr);
+
+        std::cout << "Serving on " << socket_path << " (Ctrl+C to stop)" << std::endl;
+        while (!server_stop_requested) {
+            wait_for_events();
+            accept_clients();
+            for (auto& c : clients) read_client(c);
+            render_pending();
+            for (auto& c : clients) flush_client(c);
+
+            // Drop disconnected clients
+            clients.erase(std::remove_if(clients.begin(), clients.end(), [](const Client& c) {
+                if (c.closed) close(c.fd);
+                return c.closed;
+            }), clients.end());
+        }
+
+        for (auto& c : clients) close(c.fd);
+        close(listen_fd);
+        unlink(socket_path);
+        std::cout << "Server stopped" << std::endl;
+        return 0;
+    }
+
+private:
+    struct Client {
+        int fd;
+        Camera camera;
+        int cols = 0, rows = 0;   // Terminal size, 0 until the client reports it
+        bool dirty = true;        // Camera or size changed since the last frame
+        bool resized = true;      // Screen must be cleared before the next frame
+        bool closed = false;
+        std::string input;        // Partially received messages
+        KeyDecoder keys;          // Partially received escape sequences
+        std::string output;       // Encoded frame not yet sent
+        size_t sent = 0;
+    };
+
+    const Scene& scene;
+    Framebuffer fb;               // Shared by all clients, resized per frame
+    Rasterizer rasterizer;
+    TerminalRenderer terminal;    // Half blocks: the server cannot query the viewers' terminals
+    HMM_Mat4 model;
+    int listen_fd = -1;
+    std::vector<Client> clients;
+    std::vector<int> key_events;
+
+    void wait_for_events() {
+        std::vector<pollfd> fds;
+        fds.push_back({listen_fd, POLLIN, 0});
+        bool work_pending = false;
+        for (const auto& c : clients) {
+            short events = POLLIN;
+            if (c.sent < c.output.size()) events |= POLLOUT;
+            fds.push_back({c.fd, events, 0});
+            work_pending |= c.dirty && c.cols > 0 && c.output.empty();
+        }
+        poll(fds.data(), fds.size(), work_pending ? 0 : -1);
+    }
+
+    void accept_clients() {
+        while (true) {
+            int fd = accept(listen_fd, nullptr, nullptr);
+            if (fd < 0) return;
+            set_nonblocking(fd);
+            Client c;
+            c.fd = fd;
+            clients.push_back(std::move(c));
+        }
+    }
+
+    void read_client(Client& c) {
+        char buf[4096];
+        while (true) {
+            ssize_t n = recv(c.fd, buf, sizeof(buf), 0);
+            if (n > 0) {
+                c.input.append(buf, n);
+                continue;
+            }
+            if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) c.closed = true;
+            break;
+        }
+
+        // Parse complete messages
+        size_t pos = 0;
+        while (c.input.size() - pos >= 2) {
+            uint8_t type = static_cast<uint8_t>(c.input[pos]);
+            size_t length = static_cast<uint8_t>(c.input[pos + 1]);
+            if (c.input.size() - pos - 2 < length) break;
+            const uint8_t* payload = reinterpret_cast<const uint8_t*>(c.input.data() + pos + 2);
+
+            if (type == MSG_SIZE && length == 4) {
+                c.cols = std::max(1, payload[0] | (payload[1] << 8));
+                c.rows = std::max(1, payload[2] | (payload[3] << 8));
+                c.dirty = c.resized = true;
+            } else if (type == MSG_KEYS) {
+                key_events.clear();
+                c.keys.decode(reinterpret_cast<const char*>(payload), length, key_events);
+                for (int key : key_events) c.dirty |= apply_camera_key(c.camera, key);
+            }
+            pos += 2 + length;
+        }
+        c.input.erase(0, pos);
+    }
+
+    // Render a frame for every client whose view changed and whose previous
+    // frame has been fully sent; slow readers simply skip frames
+    void render_pending() {
+        for (auto& c : clients) {
+            if (c.closed || !c.dirty || c.cols == 0 || !c.output.empty()) continue;
+            TRACE_SCOPE("client frame");
+
+            int screen_height = std::max(1, c.rows - SERVER_STATUS_ROWS);
+            fb.resize(c.cols, screen_height * 2);
+            fb.clear();
+            Viewport view = {0, 0, fb.width, fb.height, HMM_M4D(1.0f), HMM_MulM4(c.camera.get_view_matrix(), model)};
+            view.mvp = HMM_MulM4(make_projection(fb.width, fb.height), view.model_view);
+            rasterizer.draw_items(scene.draw_list(), {&view, 1});
+
+            terminal.encode(fb, c.output);
+            if (c.resized) c.output.insert(0, "\033[2J\033[?25l");
+
+            std::ostringstream status;
+            status << std::fixed << std::setprecision(1)
+                   << "\033[" << (screen_height + 2) << ";1H\033[K"
+                   << "Clients: " << clients.size()
+                   << "  Res: " << fb.width << "x" << fb.height
+                   << "  Pos: (" << c.camera.position.X << ", " << c.camera.position.Y << ", "
+                   << c.camera.position.Z << ")"
+                   << "\033[" << (screen_height + 3) << ";1H\033[K"
+                   << "[WASD] Move  [QE] Up/Down  [IJKL/Arrows] Look  [R] Reset  (shared server)";
+            c.output += status.str();
+
+            c.sent = 0;
+            c.dirty = c.resized = false;
+        }
+    }
+
+    void flush_client(Client& c) {
+        while (!c.closed && c.sent < c.output.size()) {
+            ssize_t n = send(c.fd, c.output.data() + c.sent, c.output.size() - c.sent, MSG_NOSIGNAL);
+            if (n > 0) {
+                c.sent += n;
+            } else {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) c.closed = true;
+                return;
+            }
+        }
+        if (c.sent == c.output.size()) {
+            c.output.clear();
+            c.sent = 0;
+        }
+    }
+};
+
+// Thin viewer: forwards keys and terminal size to a server, prints its frames
+inline int run_client(const char* socket_path) {
+    sockaddr_un addr;
+    if (!make_socket_address(socket_path, addr)) return 1;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        std::cerr << "Failed to connect to " << socket_path << ": " << strerror(errno) << std::endl;
+        return 1;
+    }
+
+    auto send_all = [fd](const std::string& msg) {
+        size_t off = 0;
+        while (off < msg.size()) {
+            ssize_t n = send(fd, msg.data() + off, msg.size() - off, MSG_NOSIGNAL);
+            if (n <= 0) return false;
+            off += n;
+        }
+        return true;
+    };
+
+    TerminalRenderer::init();
+    watch_terminal_resize();
+    int cols = 0, rows = 0;
+    std::string input;
+    char buf[65536];
+    while (true) {
+        // Report terminal size changes
+        int new_cols = cols, new_rows = rows;
+        if (terminal_resized()) get_terminal_size(new_cols, new_rows);
+        if (new_cols != cols || new_rows != rows) {
+            cols = new_cols;
+            rows = new_rows;
+            std::string msg = {static_cast<char>(MSG_SIZE), 4,
+                               static_cast<char>(cols & 0xFF), static_cast<char>(cols >> 8),
+                               static_cast<char>(rows & 0xFF), static_cast<char>(rows >> 8)};
+            if (!send_all(msg)) break;
+        }
+
+        // Forward key presses
+        input.clear();
+        read_input(input);
+        bool sent = true;
+        for (size_t off = 0; off < input.size() && sent; off += 255) {
+            size_t length = std::min<size_t>(255, input.size() - off);
+            std::string msg = {static_cast<char>(MSG_KEYS), static_cast<char>(length)};
+            sent = send_all(msg + input.substr(off, length));
+        }
+        if (!sent) break;
+
+        // Print whatever the server has sent
+        pollfd pfd = {fd, POLLIN, 0};
+        if (poll(&pfd, 1, 15) > 0) {
+            ssize_t n = recv(fd, buf, sizeof(buf), 0);
+            if (n <= 0) break;
+            fwrite(buf, 1, n, stdout);
+            fflush(stdout);
+        }
+    }
+
+    close(fd);
+    TerminalRenderer::cleanup();
+    std::cout << "\nDisconnected from server" << std::endl;
+    return 0;
+}
+
+#endif  // _WIN32
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+
+// ============================================================================
+// Adaptive resolution - hold a frame-time budget by rendering fewer pixels
+// ============================================================================
+//
+// The framebuffer is rendered at `scale` times the terminal resolution and
+// stretched back up while encoding. Raster, shade and encode cost follow the
+// pixel count (scale squared); vertex and setup do not, so a frame that is
+// slow because of geometry alone settles at `min_scale`.
+//
+// The scale drops as soon as the smoothed frame time exceeds the budget,
+// creeps back up while there is headroom, and returns to full resolution
+// quickly once the camera stops, when detail matters most.
+
+class ResolutionScaler {
+public:
+    double target_ms = 1000.0 / 30.0;
+    float min_scale = 0.25f;
+    float scale = 1.0f;
+
+    // Scale changes are multiples of STEP so the framebuffer is not
+    // resized on every frame
+    static constexpr float STEP = 0.05f;
+
+    // The camera counts as stopped after this long without movement; key
+    // repeat leaves gaps of a frame or two between moves
+    static constexpr double SETTLE_MS = 500.0;
+
+    // Account for the last frame; `camera_moving` is false when the view did
+    // not change. Returns true if the scale changed.
+    bool update(double frame_ms, bool camera_moving) {
+        smoothed_ms = (smoothed_ms <= 0) ? frame_ms : smoothed_ms * 0.7 + frame_ms * 0.3;
+        still_ms = camera_moving ? 0.0 : still_ms + frame_ms;
+
+        float next = scale;
+        if (still_ms >= SETTLE_MS) {
+            next = scale + 2 * STEP;
+        } else if (smoothed_ms > target_ms * 1.1) {
+            // Pixel cost goes with scale^2; round down so one step is enough
+            next = scale * static_cast<float>(std::sqrt(target_ms / smoothed_ms));
+            next = std::floor(next / STEP) * STEP;
+        } else if (smoothed_ms < target_ms * 0.7) {
+            next = scale + STEP;
+        }
+        next = std::clamp(next, min_scale, 1.0f);
+        if (std::abs(next - scale) < STEP * 0.5f) return false;
+
+        scale = next;
+        smoothed_ms = 0;    // The old frame times no longer apply
+        return true;
+    }
+
+    // Render size for an output of `width` x `height` pixels
+    void render_size(int width, int height, int& render_width, int& render_height) const {
+        render_width = std::max(1, static_cast<int>(std::lround(width * scale)));
+        render_height = std::max(1, static_cast<int>(std::lround(height * scale)));
+    }
+
+private:
+    double smoothed_ms = 0;
+    double still_ms = 0;
+};
@@ -0,0 +1,332 @@
+#pragma once
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "HandmadeMath.h"
+#include "parallel-util.hpp"
+#include "mesh.h"
+#include "texture.h"
+#include "rasterizer.h"
+
+// ============================================================================
+// Scene - meshes placed any number of times with their own transforms
+// ============================================================================
+//
+// Each mesh is stored once with its object-space bounds; instances only add
+// a transform, so repeated props share their vertex and index data. The
+// scene hands the rasterizer one DrawItem per instance, drawn in a single
+// batched draw_items() call that culls whole instances by their bounds.
+//
+// Scene files list meshes, then instances of them ('#' starts a comment;
+// paths are relative to the scene file):
+//   mesh NAME FILE.obj [TEXTURE.png]
+//   instance NAME X Y Z [YAW_DEG] [SCALE]
+// A directory loads every OBJ below it in place instead. Either way all
+// files are read first and imported in parallel (see import()).
+
+class Scene {
+public:
+    Scene() = default;
+    Scene(const Scene&) = delete;               // Draw items point into the scene
+    Scene& operator=(const Scene&) = delete;
+
+    // Take ownership of a texture; the pointer stays valid for the scene's lifetime
+    const Texture* add_texture(Texture texture) {
+        textures.push_back(std::make_unique<Texture>(std::move(texture)));
+        return textures.back().get();
+    }
+
+    // Add geometry drawn with `texture` (nullptr = the rasterizer's texture);
+    // returns the mesh index for add_instance()
+    int add_mesh(Mesh mesh, const Texture* texture = nullptr, std::string name = "") {
+        auto object = std::make_unique<Object>();
+        object->name = std::move(name);
+        object->mesh = std::move(mesh);
+        object->texture = texture;
+        object->mesh.get_box(object->bounds[0], object->bounds[1]);
+        objects.push_back(std::move(object));
+        return static_cast<int>(objects.size()) - 1;
+    }
+
+    // Place mesh `mesh` in the scene as it is
+    void add_instance(int mesh) {
+        add_item(mesh, nullptr);
+    }
+
+    // Place mesh `mesh` with an object-to-world transform
+    void add_instance(int mesh, const HMM_Mat4& transform) {
+        transforms.push_back(transform);
+        add_item(mesh, &transforms.back());
+    }
+
+    // Index of the mesh called `name`, or -1
+    int find_mesh(const std::string& name) const {
+        for (size_t i = 0; i < objects.size(); i++) {
+            if (objects[i]->name == name) return static_cast<int>(i);
+        }
+        return -1;
+    }
+
+    std::span<const DrawItem> draw_list() const { return items; }
+    size_t mesh_count() const { return objects.size(); }
+    size_t instance_count() const { return items.size(); }
+    const Mesh& mesh(int index) const { return objects[index]->mesh; }
+
+    // Vertices stored, shared by all instances of a mesh
+    size_t vertex_count() const {
+        size_t total = 0;
+        for (const auto& object : objects) total += object->mesh.vertices.size();
+        return total;
+    }
+
+    // Triangles submitted per view, counting every instance
+    size_t triangle_count() const {
+        size_t total = 0;
+        for (const DrawItem& item : items) total += item.mesh->indices.size() / 3;
+        return total;
+    }
+
+    // Center and largest extent of the world-space bounds of all instances
+    void get_bounds(HMM_Vec3& center, float& scale) const {
+        HMM_Vec3 lo = HMM_V3(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(),
+                             std::numeric_limits<float>::max());
+        HMM_Vec3 hi = HMM_V3(std::numeric_limits<float>::lowest(), std::numeric_limits<float>::lowest(),
+                             std::numeric_limits<float>::lowest());
+        for (const DrawItem& item : items) {
+            for (int corner = 0; corner < 8; corner++) {
+                HMM_Vec4 p = HMM_V4((corner & 1) ? item.bounds[1].X : item.bounds[0].X,
+                                    (corner & 2) ? item.bounds[1].Y : item.bounds[0].Y,
+                                    (corner & 4) ? item.bounds[1].Z : item.bounds[0].Z, 1.0f);
+                if (item.model) p = HMM_MulM4V4(*item.model, p);
+                lo = HMM_V3(std::min(lo.X, p.X), std::min(lo.Y, p.Y), std::min(lo.Z, p.Z));
+                hi = HMM_V3(std::max(hi.X, p.X), std::max(hi.Y, p.Y), std::max(hi.Z, p.Z));
+            }
+        }
+        Mesh::box_center_scale(lo, hi, center, scale);
+    }
+
+    // Load a scene file (see above), or every OBJ under a directory
+    bool load(const char* path) {
+        std::error_code ec;
+        if (std::filesystem::is_directory(path, ec)) return load_directory(path);
+
+        FILE* f = fopen(path, "r");
+        if (!f) {
+            std::cerr << "Failed to open scene: " << path << std::endl;
+            return false;
+        }
+        std::filesystem::path base = std::filesystem::path(path).parent_path();
+        auto resolve = [&base](const char* file) { return (base / file).string(); };
+
+        // Parse everything first so all assets can be imported at once
+        std::vector<MeshSource> sources;
+        std::vector<std::pair<int, HMM_Mat4>> placements;   // (source, transform)
+        char line[1024];
+        int line_number = 0;
+        bool ok = true;
+        while (ok && fgets(line, sizeof(line), f)) {
+            line_number++;
+            if (char* comment = strchr(line, '#')) *comment = '\0';
+
+            char keyword[16], name[256], file[512], texture_file[512];
+            if (sscanf(line, "%15s", keyword) != 1) continue;  // Blank or comment-only line
+            auto fail = [&](const char* message) {
+                std::cerr << path << ":" << line_number << ": " << message << std::endl;
+                ok = false;
+            };
+            if (strcmp(keyword, "mesh") == 0) {
+                int n = sscanf(line, "%*s %255s %511s %511s", name, file, texture_file);
+                if (n < 2) {
+                    fail("expected \"mesh NAME FILE.obj [TEXTURE.png]\"");
+                } else {
+                    sources.push_back({name, resolve(file), (n == 3) ? resolve(texture_file) : ""});
+                }
+            } else if (strcmp(keyword, "instance") == 0) {
+                float x, y, z, yaw_deg = 0.0f, scale = 1.0f;
+                int n = sscanf(line, "%*s %255s %f %f %f %f %f", name, &x, &y, &z, &yaw_deg, &scale);
+                auto source = std::find_if(sources.begin(), sources.end(),
+                                           [&name](const MeshSource& m) { return m.name == name; });
+                if (n < 4) {
+                    fail("expected \"instance NAME X Y Z [YAW_DEG] [SCALE]\"");
+                } else if (source == sources.end()) {
+                    fail("unknown mesh");
+                } else {
+                    HMM_Mat4 transform = HMM_MulM4(HMM_Translate(HMM_V3(x, y, z)),
+                                                   HMM_MulM4(HMM_Rotate_RH(HMM_AngleDeg(yaw_deg), HMM_V3(0, 1, 0)),
+                                                             HMM_Scale(HMM_V3(scale, scale, scale))));
+                    placements.emplace_back(static_cast<int>(source - sources.begin()), transform);
+                }
+            } else {
+                fail("expected \"mesh\" or \"instance\"");
+            }
+        }
+        fclose(f);
+        if (!ok) return false;
+        if (placements.empty()) {
+            std::cerr << "Scene has no instances: " << path << std::endl;
+            return false;
+        }
+
+        int first = static_cast<int>(objects.size());
+        if (!import(sources)) return false;
+        for (const auto& [source, transform] : placements) add_instance(first + source, transform);
+        return true;
+    }
+
+    // Load every OBJ under `directory` (recursively) as one instance in
+    // place, textured by the image with the same name next to it, if any
+    bool load_directory(const char* directory) {
+        std::vector<MeshSource> sources;
+        std::error_code ec;
+        for (auto it = std::filesystem::recursive_directory_iterator(directory, ec);
+             !ec && it != std::filesystem::recursive_directory_iterator(); it.increment(ec)) {
+            const std::filesystem::path& file = it->path();
+            if (!it->is_regular_file(ec) || !has_extension(file, {".obj"})) continue;
+            MeshSource source;
+            source.name = std::filesystem::relative(file, directory, ec).string();
+            source.path = file.string();
+            for (const char* extension : {".png", ".jpg", ".jpeg", ".tga", ".bmp"}) {
+                std::filesystem::path image = file;
+                image.replace_extension(extension);
+                if (std::filesystem::is_regular_file(image, ec)) {
+                    source.texture_path = image.string();
+                    break;
+                }
+            }
+            sources.push_back(std::move(source));
+        }
+        if (ec) {
+            std::cerr << "Failed to read scene directory: " << directory << std::endl;
+            return false;
+        }
+        if (sources.empty()) {
+            std::cerr << "No OBJ files in " << directory << std::endl;
+            return false;
+        }
+        // Directory order is unspecified; keep scenes reproducible
+        std::sort(sources.begin(), sources.end(),
+                  [](const MeshSource& a, const MeshSource& b) { return a.path < b.path; });
+
+        int first = static_cast<int>(objects.size());
+        if (!import(sources)) return false;
+        for (int i = first; i < static_cast<int>(objects.size()); i++) add_instance(i);
+        return true;
+    }
+
+private:
+    // A mesh to import and the image it is drawn with (empty: none)
+    struct MeshSource {
+        std::string name;
+        std::string path;
+        std::string texture_path;
+    };
+
+    struct Object {
+        std::string name;
+        Mesh mesh;
+        const Texture* texture = nullptr;
+        HMM_Vec3 bounds[2];     // Object-space {min, max}
+    };
+
+    std::vector<std::unique_ptr<Object>> objects;
+    std::vector<std::unique_ptr<Texture>> textures;
+    std::deque<HMM_Mat4> transforms;    // Deque: growing it keeps item pointers valid
+    std::vector<DrawItem> items;        // One per instance
+
+    static bool has_extension(const std::filesystem::path& file, std::initializer_list<const char*> extensions) {
+        std::string extension = file.extension().string();
+        std::transform(extension.begin(), extension.end(), extension.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        for (const char* e : extensions) {
+            if (extension == e) return true;
+        }
+        return false;
+    }
+
+    // Parse all OBJs and decode all distinct textures concurrently, then add
+    // the meshes in `sources` order. Textures shared by several meshes (by
+    // canonical path) are decoded and stored once.
+    bool import(const std::vector<MeshSource>& sources) {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::string> texture_paths;
+        std::vector<int> texture_of(sources.size(), -1);
+        std::map<std::string, int> texture_index;
+        for (size_t i = 0; i < sources.size(); i++) {
+            if (sources[i].texture_path.empty()) continue;
+            std::error_code ec;
+            std::string key = std::filesystem::weakly_canonical(sources[i].texture_path, ec).string();
+            if (ec) key = sources[i].texture_path;
+            auto [it, added] = texture_index.emplace(key, static_cast<int>(texture_paths.size()));
+            if (added) texture_paths.push_back(sources[i].texture_path);
+            texture_of[i] = it->second;
+        }
+
+        // One task per file on a shared queue: file sizes vary a lot, so
+        // workers take the next file as they finish instead of fixed shares
+        int num_meshes = static_cast<int>(sources.size());
+        int num_tasks = num_meshes + static_cast<int>(texture_paths.size());
+        std::vector<Mesh> meshes(sources.size());
+        std::vector<Texture> loaded(texture_paths.size());
+        std::vector<uint8_t> failed(num_tasks);  // One writer per entry
+        parallelutil::queue_based_parallel_for(num_tasks, [&](int task) {
+            bool ok = (task < num_meshes) ? meshes[task].load_obj(sources[task].path.c_str(), false)
+                                          : loaded[task - num_meshes].load(texture_paths[task - num_meshes].c_str(), false);
+            failed[task] = !ok;
+        }, worker_count());
+
+        for (int task = 0; task < num_meshes; task++) {
+            if (!failed[task]) continue;
+            std::cerr << "Failed to import " << sources[task].path << std::endl;
+            return false;
+        }
+        // A texture that fails only costs its meshes their texture, like a single OBJ's
+        std::vector<const Texture*> stored;
+        size_t textures = 0;
+        for (size_t t = 0; t < loaded.size(); t++) {
+            if (failed[num_meshes + t]) {
+                std::cerr << "Warning: Failed to load texture " << texture_paths[t] << ", using default color"
+                          << std::endl;
+                stored.push_back(nullptr);
+            } else {
+                stored.push_back(add_texture(std::move(loaded[t])));
+                textures++;
+            }
+        }
+        size_t vertices = 0;
+        for (size_t i = 0; i < sources.size(); i++) {
+            vertices += meshes[i].vertices.size();
+            add_mesh(std::move(meshes[i]), texture_of[i] >= 0 ? stored[texture_of[i]] : nullptr, sources[i].name);
+        }
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        std::cout << "Imported " << sources.size() << " meshes (" << vertices << " vertices) and "
+                  << textures << " textures in " << std::fixed << std::setprecision(2) << seconds
+                  << "s" << std::defaultfloat << std::endl;
+        return true;
+    }
+
+    void add_item(int mesh, const HMM_Mat4* transform) {
+        const Object& object = *objects[mesh];
+        DrawItem item;
+        item.mesh = &object.mesh;
+        item.texture = object.texture;
+        item.model = transform;
+        item.bounds = object.bounds;
+        items.push_back(item);
+    }
+};
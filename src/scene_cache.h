@@ -0,0 +1,289 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <system_error>
+
+#include "mesh.h"
+#include "texture.h"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// ============================================================================
+// Scene cache - decoded mesh and texture in a read-only memory-mapped file
+// ============================================================================
+//
+// The first process to load a scene writes the decoded vertices, indices and
+// RGBA texels to a cache file; every process (including that one) then maps
+// it read-only and points Mesh/Texture at the mapping. The OS shares the
+// pages between all viewers, so N processes cost one copy of the scene.
+//
+// Layout: SceneCacheHeader, then the vertex, index and texel arrays, each
+// starting on a 64-byte boundary. The header records the size and mtime of
+// the source files so a stale cache is rebuilt instead of used.
+
+// Read-only mapping of a whole file, unmapped when the last owner goes away
+class MappedFile {
+public:
+    ~MappedFile() {
+#ifdef _WIN32
+        if (view) UnmapViewOfFile(view);
+        if (mapping) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+        if (view) munmap(view, length);
+#endif
+    }
+
+    static std::shared_ptr<MappedFile> open(const char* filename) {
+        auto mapped = std::shared_ptr<MappedFile>(new MappedFile());
+#ifdef _WIN32
+        mapped->file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                                   OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (mapped->file == INVALID_HANDLE_VALUE) return nullptr;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(mapped->file, &size) || size.QuadPart == 0) return nullptr;
+        mapped->length = static_cast<size_t>(size.QuadPart);
+        mapped->mapping = CreateFileMappingA(mapped->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapped->mapping) return nullptr;
+        mapped->view = MapViewOfFile(mapped->mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!mapped->view) return nullptr;
+#else
+        int fd = ::open(filename, O_RDONLY);
+        if (fd < 0) return nullptr;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            close(fd);
+            return nullptr;
+        }
+        mapped->length = static_cast<size_t>(st.st_size);
+        void* view = mmap(nullptr, mapped->length, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);  // The mapping keeps the file referenced
+        if (view == MAP_FAILED) return nullptr;
+        mapped->view = view;
+#endif
+        return mapped;
+    }
+
+    const uint8_t* data() const { return static_cast<const uint8_t*>(view); }
+    size_t size() const { return length; }
+
+private:
+    MappedFile() = default;
+
+    void* view = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = nullptr;
+#endif
+};
+
+struct SceneCacheHeader {
+    char magic[8];              // "CLRSCN\0\0"
+    uint32_t version;
+    uint32_t vertex_size;       // sizeof(Vertex) of the writer, guards against layout changes
+    uint64_t obj_size;          // Source files the cache was built from
+    int64_t obj_mtime;
+    uint64_t texture_size;      // 0 when the texture file is missing
+    int64_t texture_mtime;
+    uint64_t vertex_count, vertex_offset;
+    uint64_t index_count, index_offset;
+    uint64_t texel_offset;
+    int32_t texture_width, texture_height;
+    int32_t texture_has_alpha;
+    int32_t texture_channels;
+};
+
+constexpr char SCENE_CACHE_MAGIC[8] = {'C', 'L', 'R', 'S', 'C', 'N', 0, 0};
+constexpr uint32_t SCENE_CACHE_VERSION = 3;
+
+// Size and modification time identifying a source file version; zeros if missing
+inline void source_stamp(const char* filename, uint64_t& size, int64_t& mtime) {
+    std::error_code ec;
+    size = 0;
+    mtime = 0;
+    if (!filename) return;
+    auto s = std::filesystem::file_size(filename, ec);
+    if (ec) return;
+    auto t = std::filesystem::last_write_time(filename, ec);
+    if (ec) return;
+    size = s;
+    mtime = static_cast<int64_t>(t.time_since_epoch().count());
+}
+
+inline uint64_t align_cache_offset(uint64_t offset) {
+    return (offset + 63) & ~uint64_t(63);
+}
+
+// Map `cache_path` into `mesh`/`texture` if it was built from the current
+// versions of the source files; returns false if missing, stale or invalid
+inline bool load_scene_cache(const char* cache_path, const char* obj_path, const char* tex_path,
+                             Mesh& mesh, Texture& texture) {
+    std::shared_ptr<MappedFile> file = MappedFile::open(cache_path);
+    if (!file || file->size() < sizeof(SceneCacheHeader)) return false;
+
+    SceneCacheHeader h;
+    memcpy(&h, file->data(), sizeof(h));
+    if (memcmp(h.magic, SCENE_CACHE_MAGIC, sizeof(h.magic)) != 0 ||
+        h.version != SCENE_CACHE_VERSION || h.vertex_size != sizeof(Vertex)) {
+        std::cerr << "Ignoring incompatible scene cache: " << cache_path << std::endl;
+        return false;
+    }
+
+    uint64_t obj_size, texture_size;
+    int64_t obj_mtime, texture_mtime;
+    source_stamp(obj_path, obj_size, obj_mtime);
+    source_stamp(tex_path, texture_size, texture_mtime);
+    if (h.obj_size != obj_size || h.obj_mtime != obj_mtime ||
+        h.texture_size != texture_size || h.texture_mtime != texture_mtime) {
+        std::cout << "Scene cache is out of date: " << cache_path << std::endl;
+        return false;
+    }
+
+    uint64_t texel_bytes = static_cast<uint64_t>(h.texture_width) * h.texture_height * 4;
+    if (h.vertex_offset + h.vertex_count * sizeof(Vertex) > file->size() ||
+        h.index_offset + h.index_count * sizeof(unsigned int) > file->size() ||
+        (texel_bytes > 0 && h.texel_offset + texel_bytes > file->size())) {
+        std::cerr << "Truncated scene cache: " << cache_path << std::endl;
+        return false;
+    }
+
+    const uint8_t* base = file->data();
+    mesh.set_view({reinterpret_cast<const Vertex*>(base + h.vertex_offset), h.vertex_count},
+                  {reinterpret_cast<const unsigned int*>(base + h.index_offset), h.index_count},
+                  file);
+    if (texel_bytes > 0) {
+        texture.set_view(h.texture_width, h.texture_height, {base + h.texel_offset, texel_bytes},
+                         h.texture_has_alpha != 0, file);
+        texture.channels = h.texture_channels;
+    }
+
+    std::cout << "Mapped scene cache " << cache_path << " (" << mesh.vertices.size()
+              << " vertices, " << (file->size() >> 20) << " MB shared)" << std::endl;
+    return true;
+}
+
+// Exclusive lock on `cache_path`.lock while a process checks and builds the
+// cache, so viewers started together wait for the first one to publish it and
+// then map it instead of each building a private copy. No-op for nullptr.
+class SceneCacheLock {
+public:
+    explicit SceneCacheLock(const char* cache_path) {
+        if (!cache_path) return;
+        std::string lock_path = std::string(cache_path) + ".lock";
+#ifdef _WIN32
+        file = CreateFileA(lock_path.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                           nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        OVERLAPPED overlapped = {};
+        if (file != INVALID_HANDLE_VALUE && !LockFileEx(file, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &overlapped)) {
+            CloseHandle(file);
+            file = INVALID_HANDLE_VALUE;
+        }
+#else
+        fd = ::open(lock_path.c_str(), O_RDWR | O_CREAT, 0644);
+        if (fd >= 0 && flock(fd, LOCK_EX) != 0) {
+            close(fd);
+            fd = -1;
+        }
+#endif
+        // Without a lock concurrent builders still work, they just don't share
+    }
+
+    ~SceneCacheLock() {
+#ifdef _WIN32
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+#else
+        if (fd >= 0) close(fd);     // Releases the lock
+#endif
+    }
+
+    SceneCacheLock(const SceneCacheLock&) = delete;
+    SceneCacheLock& operator=(const SceneCacheLock&) = delete;
+
+private:
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+#else
+    int fd = -1;
+#endif
+};
+
+// Write `mesh` and `texture` to `cache_path`. The file is written under a
+// temporary name unique to this writer and renamed, so concurrent readers
+// never map a partial cache and concurrent writers never share a file.
+inline bool write_scene_cache(const char* cache_path, const char* obj_path, const char* tex_path,
+                              const Mesh& mesh, const Texture& texture) {
+    SceneCacheHeader h = {};
+    memcpy(h.magic, SCENE_CACHE_MAGIC, sizeof(h.magic));
+    h.version = SCENE_CACHE_VERSION;
+    h.vertex_size = sizeof(Vertex);
+    source_stamp(obj_path, h.obj_size, h.obj_mtime);
+    source_stamp(tex_path, h.texture_size, h.texture_mtime);
+
+    h.vertex_count = mesh.vertices.size();
+    h.vertex_offset = align_cache_offset(sizeof(h));
+    h.index_count = mesh.indices.size();
+    h.index_offset = align_cache_offset(h.vertex_offset + h.vertex_count * sizeof(Vertex));
+    h.texel_offset = align_cache_offset(h.index_offset + h.index_count * sizeof(unsigned int));
+    if (texture.loaded) {
+        h.texture_width = texture.width;
+        h.texture_height = texture.height;
+        h.texture_has_alpha = texture.has_alpha ? 1 : 0;
+        h.texture_channels = texture.channels;
+    }
+
+#ifdef _WIN32
+    unsigned long pid = GetCurrentProcessId();
+#else
+    unsigned long pid = static_cast<unsigned long>(getpid());
+#endif
+    std::string temp_path = std::string(cache_path) + ".tmp." + std::to_string(pid) + "." +
+                            std::to_string(std::random_device()());
+    FILE* f = fopen(temp_path.c_str(), "wbx");
+    if (!f) {
+        std::cerr << "Failed to write scene cache: " << cache_path << std::endl;
+        return false;
+    }
+
+    // Sections are written in order, zero-padded up to their aligned offset
+    uint64_t position = 0;
+    auto write_at = [f, &position](uint64_t offset, const void* bytes, size_t size) {
+        static const uint8_t zeros[64] = {};
+        if (offset < position || offset - position > sizeof(zeros) ||
+            fwrite(zeros, 1, offset - position, f) != offset - position) return false;
+        position = offset + size;
+        return size == 0 || fwrite(bytes, 1, size, f) == size;
+    };
+    bool ok = write_at(0, &h, sizeof(h)) &&
+              write_at(h.vertex_offset, mesh.vertices.data(), mesh.vertices.size_bytes()) &&
+              write_at(h.index_offset, mesh.indices.data(), mesh.indices.size_bytes()) &&
+              (!texture.loaded || write_at(h.texel_offset, texture.data.data(), texture.data.size_bytes()));
+    ok = (fclose(f) == 0) && ok;
+
+    std::error_code ec;
+    if (ok) std::filesystem::rename(temp_path, cache_path, ec);
+    if (!ok || ec) {
+        std::filesystem::remove(temp_path, ec);
+        std::cerr << "Failed to write scene cache: " << cache_path << std::endl;
+        return false;
+    }
+    return true;
+}
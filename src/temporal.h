@@ -0,0 +1,213 @@
+#pragma once
+
+#include <cmath>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "HandmadeMath.h"
+#include "framebuffer.h"
+#include "rasterizer.h"
+#include "trace.h"
+
+// ============================================================================
+// Temporal reprojection - reuse the previous frame during small camera moves
+// ============================================================================
+//
+// begin_frame() forward-projects every pixel of the previous frame into the
+// new view using its depth, closes single-pixel cracks from neighbours and
+// marks each REUSE_TILE_SIZE tile that still has a hole (disocclusion, screen
+// edge, magnification) as invalid. Only invalid tiles are cleared and
+// rasterized again; the rest keep the reprojected color.
+//
+// Reprojected pixels keep the lighting of the frame they were rendered in,
+// and resampling slowly blurs them, so the whole frame is re-rendered every
+// `refresh_interval` frames and whenever too many tiles would be invalid.
+
+class TemporalReprojector {
+public:
+    int refresh_interval = 30;          // Full render at least every N frames
+    float max_invalid_fraction = 0.6f;  // Above this, a full render is cheaper
+
+    // Result of the most recent begin_frame()
+    int tiles_total = 0;
+    int tiles_reused = 0;
+
+    // Forget the previous frame, e.g. after the layout or scene changed
+    void invalidate() {
+        has_history = false;
+    }
+
+    // Prepare `fb` for a frame seen through `mvp` and tell `rasterizer` which
+    // tiles to skip. Returns false if the frame must be rendered in full
+    // (the framebuffer was cleared and nothing is skipped).
+    bool begin_frame(Framebuffer& fb, Rasterizer& rasterizer, const HMM_Mat4& mvp) {
+        TRACE_SCOPE("reproject");
+        int tiles_x = (fb.width + REUSE_TILE_SIZE - 1) >> REUSE_TILE_SHIFT;
+        int tiles_y = (fb.height + REUSE_TILE_SIZE - 1) >> REUSE_TILE_SHIFT;
+        tiles_total = tiles_x * tiles_y;
+        tiles_reused = 0;
+        rasterizer.set_reused_tiles(nullptr);
+
+        bool full = !has_history || fb.width != prev_width || fb.height != prev_height ||
+                    ++frames_since_refresh >= refresh_interval;
+        if (full) {
+            frames_since_refresh = 0;
+            fb.clear();
+            return false;
+        }
+
+        if (memcmp(&mvp, &prev_mvp, sizeof(HMM_Mat4)) == 0) {
+            restore_previous(fb);   // Camera did not move: the last frame is exact
+        } else {
+            splat_previous(fb, mvp);
+            fill_cracks(fb);
+        }
+
+        // Tiles with remaining holes are rasterized again from scratch
+        reused.assign(tiles_total, 1);
+        const uint32_t hole = HOLE_DEPTH;
+        parallel_chunks(tiles_y, worker_count(), [&](int, int begin, int end) {
+            for (int ty = begin; ty < end; ty++) {
+                int y_end = std::min(fb.height, (ty + 1) * REUSE_TILE_SIZE);
+                for (int y = ty * REUSE_TILE_SIZE; y < y_end; y++) {
+                    for (int x = 0; x < fb.width; x++) {
+                        if (fb.depth_buffer[y * fb.width + x].load(std::memory_order_relaxed) == hole) {
+                            reused[ty * tiles_x + (x >> REUSE_TILE_SHIFT)] = 0;
+                        }
+                    }
+                }
+            }
+        });
+        for (uint8_t r : reused) tiles_reused += r;
+
+        if (tiles_total - tiles_reused > max_invalid_fraction * tiles_total) {
+            frames_since_refresh = 0;
+            tiles_reused = 0;
+            fb.clear();
+            return false;
+        }
+
+        Color background = Framebuffer::background_color();
+        uint32_t far_depth = Framebuffer::far_depth();
+        parallel_chunks(fb.height, worker_count(), [&](int, int begin, int end) {
+            for (int y = begin; y < end; y++) {
+                const uint8_t* tile_row = &reused[(y >> REUSE_TILE_SHIFT) * tiles_x];
+                for (int x = 0; x < fb.width; x++) {
+                    if (tile_row[x >> REUSE_TILE_SHIFT]) continue;
+                    fb.color_buffer[y * fb.width + x] = background;
+                    fb.depth_buffer[y * fb.width + x].store(far_depth, std::memory_order_relaxed);
+                }
+            }
+        });
+        rasterizer.set_reused_tiles(&reused);
+        return true;
+    }
+
+    // Keep the finished frame as the source of the next reprojection
+    void end_frame(const Framebuffer& fb, const HMM_Mat4& mvp) {
+        TRACE_SCOPE("keep frame");
+        size_t size = static_cast<size_t>(fb.width) * fb.height;
+        prev_color.assign(fb.color_buffer.begin(), fb.color_buffer.begin() + size);
+        prev_depth.resize(size);
+        for (size_t i = 0; i < size; i++) prev_depth[i] = fb.depth_buffer[i].load(std::memory_order_relaxed);
+        prev_width = fb.width;
+        prev_height = fb.height;
+        prev_mvp = mvp;
+        prev_inv_mvp = HMM_InvGeneralM4(mvp);
+        has_history = true;
+    }
+
+private:
+    // Not a valid encoded depth: marks pixels nothing was reprojected onto
+    static constexpr uint32_t HOLE_DEPTH = 0xFFFFFFFFu;
+
+    std::vector<Color> prev_color;
+    std::vector<uint32_t> prev_depth;
+    std::vector<uint32_t> depth_snapshot;
+    std::vector<uint8_t> reused;
+    HMM_Mat4 prev_mvp;
+    HMM_Mat4 prev_inv_mvp;
+    int prev_width = 0, prev_height = 0;
+    int frames_since_refresh = 0;
+    bool has_history = false;
+
+    void restore_previous(Framebuffer& fb) {
+        std::copy(prev_color.begin(), prev_color.end(), fb.color_buffer.begin());
+        for (size_t i = 0; i < prev_depth.size(); i++) {
+            fb.depth_buffer[i].store(prev_depth[i], std::memory_order_relaxed);
+        }
+    }
+
+    // Move every previous pixel to where it lands in the new view. Background
+    // pixels are treated as lying on the far plane and keep the far depth, so
+    // they cover holes but never hide geometry.
+    void splat_previous(Framebuffer& fb, const HMM_Mat4& mvp) {
+        size_t size = static_cast<size_t>(fb.width) * fb.height;
+        for (size_t i = 0; i < size; i++) fb.depth_buffer[i].store(HOLE_DEPTH, std::memory_order_relaxed);
+
+        HMM_Mat4 reproject = HMM_MulM4(mvp, prev_inv_mvp);
+        uint32_t far_depth = Framebuffer::far_depth();
+        parallel_chunks(fb.height, worker_count(), [&](int, int begin, int end) {
+            for (int y = begin; y < end; y++) {
+                float ndc_y = 1.0f - (y + 0.5f) * 2.0f / fb.height;
+                for (int x = 0; x < fb.width; x++) {
+                    int src = y * fb.width + x;
+                    bool background = prev_depth[src] >= far_depth;
+                    float ndc_x = (x + 0.5f) * 2.0f / fb.width - 1.0f;
+                    float ndc_z = background ? 1.0f : uint32_to_float(prev_depth[src]);
+
+                    HMM_Vec4 clip = HMM_MulM4V4(reproject, HMM_V4(ndc_x, ndc_y, ndc_z, 1.0f));
+                    if (clip.W <= Rasterizer::NEAR_W) continue;
+                    float inv_w = 1.0f / clip.W;
+                    int dx = static_cast<int>(std::floor((clip.X * inv_w + 1.0f) * 0.5f * fb.width));
+                    int dy = static_cast<int>(std::floor((1.0f - clip.Y * inv_w) * 0.5f * fb.height));
+                    if (dx < 0 || dx >= fb.width || dy < 0 || dy >= fb.height) continue;
+
+                    float depth = clip.Z * inv_w;
+                    if (!background && (depth < -1.0f || depth > 1.0f)) continue;
+                    int dst = dy * fb.width + dx;
+                    uint32_t encoded = background ? far_depth : float_to_uint32(depth);
+                    uint32_t old_depth = fb.depth_buffer[dst].load(std::memory_order_relaxed);
+                    while (encoded < old_depth) {
+                        if (fb.depth_buffer[dst].compare_exchange_weak(old_depth, encoded, std::memory_order_relaxed)) {
+                            fb.color_buffer[dst] = prev_color[src];
+                            break;
+                        }
+                    }
+                }
+            }
+        });
+    }
+
+    // Fill holes surrounded on at least three sides with the nearest
+    // neighbour: forward splatting leaves such cracks wherever the view
+    // zooms in slightly, and they would otherwise invalidate most tiles
+    void fill_cracks(Framebuffer& fb) {
+        size_t size = static_cast<size_t>(fb.width) * fb.height;
+        depth_snapshot.resize(size);
+        for (size_t i = 0; i < size; i++) depth_snapshot[i] = fb.depth_buffer[i].load(std::memory_order_relaxed);
+
+        parallel_chunks(fb.height, worker_count(), [&](int, int begin, int end) {
+            for (int y = begin; y < end; y++) {
+                for (int x = 0; x < fb.width; x++) {
+                    int i = y * fb.width + x;
+                    if (depth_snapshot[i] != HOLE_DEPTH) continue;
+
+                    int neighbours[4] = {x > 0 ? i - 1 : -1, x + 1 < fb.width ? i + 1 : -1,
+                                         y > 0 ? i - fb.width : -1, y + 1 < fb.height ? i + fb.width : -1};
+                    int found = 0, nearest = -1;
+                    for (int n : neighbours) {
+                        if (n < 0 || depth_snapshot[n] == HOLE_DEPTH) continue;
+                        found++;
+                        if (nearest < 0 || depth_snapshot[n] < depth_snapshot[nearest]) nearest = n;
+                    }
+                    if (found < 3) continue;
+                    fb.color_buffer[i] = fb.color_buffer[nearest];
+                    fb.depth_buffer[i].store(depth_snapshot[nearest], std::memory_order_relaxed);
+                }
+            }
+        });
+    }
+};
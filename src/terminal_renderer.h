@@ -0,0 +1,766 @@
+#pragma once
+
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+
+#include "platform.h"
+#include "framebuffer.h"
+#include "palette.h"
+#include "trace.h"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// Implemented in stb_image_write.h (third_party.cpp); returns a zlib stream
+// to be released with free()
+extern "C" unsigned char* stbi_zlib_compress(unsigned char* data, int data_len, int* out_len, int quality);
+
+// ============================================================================
+// Terminal output - renders framebuffer to terminal
+// ============================================================================
+//
+// Backends:
+// - BLOCKS: "▀" half-block characters with 24-bit colors, two pixels per cell.
+//   Works everywhere but costs two color escapes per cell.
+// - QUADRANT / SEXTANT: 2x2 or 2x3 pixels per cell drawn with quadrant
+//   (U+2596-U+259F) or sextant (U+1FB00-U+1FB3B) block characters. Each cell
+//   is reduced to two colors, trading color accuracy for 2x or 3x the pixels
+//   at the same two color escapes per cell.
+// - SIXEL: DEC sixel image with a 6x6x6 color cube palette, each pixel scaled
+//   up to its half of a character cell.
+// - KITTY: Kitty graphics protocol; the framebuffer is sent as RGB, either
+//   zlib-compressed inline or through a POSIX shared memory object (local
+//   terminals only), and the terminal scales it to the output cells.
+//
+// The text backends (BLOCKS, QUADRANT, SEXTANT) send 24-bit colors, or
+// xterm-256 / 16-color indices with `colors` (see palette.h).
+//
+// With `bytes_per_second` set, the text backends only send cells that
+// changed, largest error first, within a token bucket that refills at that
+// rate (see encode_budgeted()).
+//
+// All backends draw from the top-left corner; a frame of `out_width` x
+// `out_height` pixels covers out_width / px columns and out_height / py rows,
+// with px x py from cell_pixels(), so the status lines below work the same
+// for each.
+
+enum class TerminalBackend { BLOCKS, SIXEL, KITTY, QUADRANT, SEXTANT };
+enum class KittyTransfer { ZLIB, SHM };
+
+// Deletes the kitty image frames are drawn into (id 1)
+constexpr const char* KITTY_DELETE_IMAGES = "\033_Ga=d,d=I,i=1,q=2\033\\";
+
+inline const char* backend_name(TerminalBackend backend) {
+    switch (backend) {
+        case TerminalBackend::SIXEL: return "sixel";
+        case TerminalBackend::KITTY: return "kitty";
+        case TerminalBackend::QUADRANT: return "quadrant";
+        case TerminalBackend::SEXTANT: return "sextant";
+        default: return "blocks";
+    }
+}
+
+// Pixels per character cell the frame should be rendered at
+inline void cell_pixels(TerminalBackend backend, int& px, int& py) {
+    switch (backend) {
+        case TerminalBackend::QUADRANT: px = 2; py = 2; break;
+        case TerminalBackend::SEXTANT: px = 2; py = 3; break;
+        default: px = 1; py = 2; break;
+    }
+}
+
+inline void append_utf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+inline void append_base64(std::string& out, const uint8_t* data, size_t size) {
+    static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t i = 0;
+    for (; i + 2 < size; i += 3) {
+        uint32_t v = (data[i] << 16) | (data[i + 1] << 8) | data[i + 2];
+        out += table[v >> 18];
+        out += table[(v >> 12) & 63];
+        out += table[(v >> 6) & 63];
+        out += table[v & 63];
+    }
+    if (i < size) {
+        uint32_t v = data[i] << 16;
+        if (i + 1 < size) v |= data[i + 1] << 8;
+        out += table[v >> 18];
+        out += table[(v >> 12) & 63];
+        out += (i + 1 < size) ? table[(v >> 6) & 63] : '=';
+        out += '=';
+    }
+}
+
+class TerminalRenderer {
+public:
+    TerminalBackend backend = TerminalBackend::BLOCKS;
+    KittyTransfer kitty_transfer = KittyTransfer::ZLIB;
+    int cell_width = 10, cell_height = 20;    // Screen pixels per character cell (sixel)
+    ColorMode colors = ColorMode::TRUECOLOR;  // Text backends only
+    bool dither = false;                      // Ordered dithering for indexed colors
+    double bytes_per_second = 0;              // Output budget of render(), 0 for none (text backends)
+
+    // Result of the most recent budgeted render()
+    int detail_level = 0;       // 0 is exact, higher levels send coarser colors
+    int deferred_cells = 0;     // Changed cells left for later frames
+
+    TerminalRenderer() = default;
+    explicit TerminalRenderer(TerminalBackend backend) : backend(backend) {}
+    TerminalRenderer(const TerminalRenderer&) = delete;
+    TerminalRenderer& operator=(const TerminalRenderer&) = delete;
+
+    // Render framebuffer to the terminal
+    // Returns the number of bytes written
+    size_t render(const Framebuffer& fb) {
+        return render(fb, fb.width, fb.height);
+    }
+
+    // Render framebuffer stretched to `out_width` x `out_height` pixels
+    size_t render(const Framebuffer& fb, int out_width, int out_height) {
+        {
+            TRACE_SCOPE("encode");
+            if (bytes_per_second > 0 && is_text_backend()) {
+                // Token bucket: credit accrues at the budget rate, up to a
+                // short burst, and every frame spends what it sends
+                auto now = std::chrono::steady_clock::now();
+                double burst = bytes_per_second * BURST_SECONDS;
+                if (has_sent) credit += bytes_per_second * std::chrono::duration<double>(now - last_send).count();
+                credit = has_sent ? std::min(credit, burst) : burst;
+                last_send = now;
+                has_sent = true;
+                encode_budgeted(fb, out_width, out_height, static_cast<size_t>(std::max(credit, 0.0)), frame);
+                credit -= static_cast<double>(frame.size());
+            } else {
+                encode(fb, out_width, out_height, frame);
+            }
+        }
+        TRACE_SCOPE("write");
+        std::cout << frame << std::flush;
+        return frame.size();
+    }
+
+    void encode(const Framebuffer& fb, std::string& output) {
+        encode(fb, fb.width, fb.height, output);
+    }
+
+    // Encode `fb` stretched to `out_width` x `out_height` pixels of the
+    // active backend (see cell_pixels())
+    void encode(const Framebuffer& fb, int out_width, int out_height, std::string& output) {
+        output.clear();
+        switch (backend) {
+            case TerminalBackend::SIXEL: encode_sixel(fb, out_width, out_height, output); break;
+            case TerminalBackend::KITTY: encode_kitty(fb, out_width, out_height, output); break;
+            case TerminalBackend::QUADRANT: encode_mosaic(fb, out_width, out_height, 2, output); break;
+            case TerminalBackend::SEXTANT: encode_mosaic(fb, out_width, out_height, 3, output); break;
+            default: encode_blocks(fb, out_width, out_height, output); break;
+        }
+    }
+
+    // Encode framebuffer as escape sequences using "▀" character
+    // Foreground color = top pixel, Background color = bottom pixel.
+    // Frames rendered below terminal resolution are stretched with
+    // nearest-neighbour sampling.
+    void encode_blocks(const Framebuffer& fb, int out_width, int out_height, std::string& output) const {
+        output.reserve(out_width * (out_height / 2) * 40);  // Pre-allocate
+
+        // Source column of each output column
+        std::vector<int> src_x(out_width);
+        for (int x = 0; x < out_width; x++) src_x[x] = x * fb.width / out_width;
+
+        // Move cursor to top-left
+        output += "\033[H";
+
+        // Process two rows at a time
+        for (int y = 0; y < out_height; y += 2) {
+            int top_y = y * fb.height / out_height;
+            int bottom_y = (y + 1) * fb.height / out_height;
+            for (int x = 0; x < out_width; x++) {
+                Color top = fb.get_pixel(src_x[x], top_y);
+                Color bottom = (y + 1 < out_height) ? fb.get_pixel(src_x[x], bottom_y) : Color(0, 0, 0);
+
+                // Set foreground (top pixel) and background (bottom pixel) colors
+                append_color(output, top, false, x, y);
+                append_color(output, bottom, true, x, y + 1);
+                output += "\xE2\x96\x80";  // UTF-8 encoding of "▀" (U+2580)
+            }
+            output += "\033[0m\n";  // Reset colors and newline
+        }
+    }
+
+    // Encode with 2 x `cell_rows` pixels per cell (2: quadrants, 3: sextants)
+    void encode_mosaic(const Framebuffer& fb, int out_width, int out_height, int cell_rows,
+                       std::string& output) {
+        int columns, rows;
+        build_cells(fb, out_width, out_height, 2, cell_rows, 0, columns, rows);
+        output.reserve(columns * rows * 42);
+        const std::string* glyphs = cell_glyphs(2, cell_rows);
+
+        output += "\033[H";
+        for (int row = 0; row < rows; row++) {
+            for (int col = 0; col < columns; col++) {
+                const TextCell& cell = cells[row * columns + col];
+                append_code(output, cell.bg, true);
+                if (cell.pattern == 0) {
+                    output += ' ';
+                    continue;
+                }
+                append_code(output, cell.fg, false);
+                output += glyphs[cell.pattern];
+            }
+            output += "\033[0m\n";
+        }
+    }
+
+    // Forget what is on screen, so the next budgeted frame redraws every
+    // cell (e.g. after clearing the screen)
+    void invalidate() {
+        shown.clear();
+    }
+
+    // Remove what the backend left on screen (kitty images stay otherwise)
+    void finish() {
+        if (backend == TerminalBackend::KITTY) std::cout << KITTY_DELETE_IMAGES << std::flush;
+#ifndef _WIN32
+        for (int i = 0; i < SHM_SLOTS; i++) shm_unlink(shm_name(i).c_str());
+#endif
+    }
+
+    // Ask the terminal which graphics protocols it supports. Needs raw input
+    // (call after init()). A kitty graphics query is answered before the
+    // primary device attributes (DA1) request, whose reply lists 4 when
+    // sixel is available; terminals that know neither just answer DA1.
+    static TerminalBackend detect_backend() {
+#ifdef _WIN32
+        return TerminalBackend::BLOCKS;
+#else
+        std::cout << "\033_Gi=31,s=1,v=1,a=q,t=d,f=24;AAAA\033\\\033[c" << std::flush;
+        std::string reply;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(300);
+        size_t da1 = std::string::npos;
+        while (true) {
+            da1 = reply.find("\033[?");
+            if (da1 != std::string::npos && reply.find('c', da1) != std::string::npos) break;
+            auto left = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            if (left <= 0 || !wait_for_input(static_cast<int>(left))) break;
+            read_input(reply);
+        }
+
+        if (reply.find("\033_Gi=31;OK") != std::string::npos) return TerminalBackend::KITTY;
+        if (da1 != std::string::npos) {
+            // "ESC [ ? 62 ; 4 ; 22 c": look for a 4 among the parameters
+            size_t end = reply.find('c', da1);
+            std::string params = ";" + reply.substr(da1 + 3, end - da1 - 3) + ";";
+            if (params.find(";4;") != std::string::npos) return TerminalBackend::SIXEL;
+        }
+        return TerminalBackend::BLOCKS;
+#endif
+    }
+
+    // Clear screen, hide cursor and switch keyboard input to raw mode
+    static void init() {
+#ifdef _WIN32
+        // Set console to UTF-8 code page
+        SetConsoleOutputCP(CP_UTF8);
+        SetConsoleCP(CP_UTF8);
+
+        // Enable virtual terminal processing for ANSI escape sequences
+        HANDLE hOut = GetStdHandle(STD_OUTPUT_HANDLE);
+        DWORD dwMode = 0;
+        GetConsoleMode(hOut, &dwMode);
+        dwMode |= ENABLE_VIRTUAL_TERMINAL_PROCESSING;
+        SetConsoleMode(hOut, dwMode);
+#endif
+        enable_raw_input();
+        std::cout << "\033[2J";     // Clear screen
+        std::cout << "\033[?25l";   // Hide cursor
+        std::cout << std::flush;
+    }
+
+    // Show cursor and reset
+    static void cleanup() {
+        restore_terminal();
+        std::cout << "\033[?25h";   // Show cursor
+        std::cout << "\033[0m";     // Reset colors
+        std::cout << std::flush;
+    }
+
+private:
+    static constexpr int KITTY_IMAGE_ID = 1;
+    static constexpr int SHM_SLOTS = 4;   // Frames the terminal has to pick up a shared memory image
+
+    std::string frame;              // Encoded output of render()
+    std::vector<uint8_t> pixels;
+    std::string payload;
+    std::vector<uint8_t> masks;     // Sixel: bits per color and column of one band
+    std::vector<uint8_t> row_colors;
+    std::vector<int> spans;         // Sixel: screen columns per framebuffer column
+    int shm_serial = 0;
+
+    // A character cell of the text backends; colors are color_code() values
+    struct TextCell {
+        uint32_t fg = UNKNOWN_COLOR, bg = UNKNOWN_COLOR;
+        uint8_t pattern = 0;    // Foreground bit per pixel in reading order, 0 for a blank
+    };
+    static constexpr uint32_t UNKNOWN_COLOR = 0xFFFFFFFF;
+
+    std::vector<TextCell> cells;    // Cells of the current frame
+    std::vector<TextCell> shown;    // Budgeted output: cells as last sent to the terminal
+    std::vector<std::pair<int, int>> candidates;  // Budgeted output: (error, cell) to send
+    int shown_columns = 0;
+    double credit = 0;              // Token bucket, bytes
+    double cell_cost = 40;          // Smoothed bytes per sent cell
+    int calm_frames = 0;            // Consecutive frames well under budget
+    bool has_sent = false;
+    std::chrono::steady_clock::time_point last_send;
+
+    static constexpr double BURST_SECONDS = 0.1;
+    static constexpr int DETAIL_LEVELS = 5;
+    // Per detail level: low bits dropped from each 24-bit color channel, and
+    // the summed channel difference per pixel below which a cell is kept
+    static constexpr int DROPPED_BITS[DETAIL_LEVELS] = {0, 2, 3, 4, 5};
+    static constexpr int SKIP_THRESHOLD[DETAIL_LEVELS] = {0, 6, 12, 24, 48};
+
+    bool is_text_backend() const {
+        return backend == TerminalBackend::BLOCKS || backend == TerminalBackend::QUADRANT ||
+               backend == TerminalBackend::SEXTANT;
+    }
+
+    // --- Text cells ---
+
+    // Fill `cells` with `cell_cols` x `cell_rows` pixels per cell. Each cell
+    // is split into two colors along the channel with the largest range;
+    // pixels above the midpoint take the foreground color, the others the
+    // background, and both are the average of their pixels. Uniform cells
+    // are a blank with only a background color.
+    void build_cells(const Framebuffer& fb, int out_width, int out_height, int cell_cols, int cell_rows,
+                     int dropped_bits, int& columns, int& rows) {
+        columns = out_width / cell_cols;
+        rows = out_height / cell_rows;
+        cells.resize(static_cast<size_t>(columns) * rows);
+
+        std::vector<int> src_x(columns * cell_cols);
+        for (int x = 0; x < columns * cell_cols; x++) src_x[x] = x * fb.width / out_width;
+
+        for (int row = 0; row < rows; row++) {
+            int src_y[3];
+            for (int i = 0; i < cell_rows; i++) src_y[i] = (row * cell_rows + i) * fb.height / out_height;
+
+            for (int col = 0; col < columns; col++) {
+                // Cell pixels in reading order: bit i of a glyph pattern is pixel i
+                Color px[6];
+                int n = 0;
+                for (int i = 0; i < cell_rows; i++) {
+                    for (int j = 0; j < cell_cols; j++) px[n++] = fb.get_pixel(src_x[col * cell_cols + j], src_y[i]);
+                }
+
+                int lo[3] = {255, 255, 255}, hi[3] = {0, 0, 0};
+                for (int i = 0; i < n; i++) {
+                    const uint8_t ch[3] = {px[i].r, px[i].g, px[i].b};
+                    for (int c = 0; c < 3; c++) {
+                        lo[c] = std::min<int>(lo[c], ch[c]);
+                        hi[c] = std::max<int>(hi[c], ch[c]);
+                    }
+                }
+                int axis = 0;
+                for (int c = 1; c < 3; c++) {
+                    if (hi[c] - lo[c] > hi[axis] - lo[axis]) axis = c;
+                }
+                int mid = (lo[axis] + hi[axis]) / 2;
+
+                int pattern = 0;
+                int sum[2][3] = {}, count[2] = {};
+                for (int i = 0; i < n; i++) {
+                    const uint8_t ch[3] = {px[i].r, px[i].g, px[i].b};
+                    int fg = ch[axis] > mid;
+                    pattern |= fg << i;
+                    count[fg]++;
+                    for (int c = 0; c < 3; c++) sum[fg][c] += ch[c];
+                }
+
+                auto average = [&](int group) {
+                    return Color(static_cast<uint8_t>(sum[group][0] / count[group]),
+                                 static_cast<uint8_t>(sum[group][1] / count[group]),
+                                 static_cast<uint8_t>(sum[group][2] / count[group]));
+                };
+                TextCell& cell = cells[row * columns + col];
+                cell.bg = color_code(average(count[0] ? 0 : 1), col, row, dropped_bits);
+                bool uniform = count[0] == 0 || count[1] == 0;
+                cell.pattern = static_cast<uint8_t>(uniform ? 0 : pattern);
+                cell.fg = uniform ? cell.bg : color_code(average(1), col + 1, row, dropped_bits);
+            }
+        }
+    }
+
+    // Sum of per-pixel channel differences between two cells of `pixels` pixels
+    int cell_error(const TextCell& a, const TextCell& b, int pixels) const {
+        if (b.bg == UNKNOWN_COLOR) return INT32_MAX;
+        Color a_colors[2] = {code_color(a.bg), code_color(a.fg)};
+        Color b_colors[2] = {code_color(b.bg), code_color(b.fg)};
+        int error = 0;
+        for (int i = 0; i < pixels; i++) {
+            const Color& ca = a_colors[(a.pattern >> i) & 1];
+            const Color& cb = b_colors[(b.pattern >> i) & 1];
+            error += std::abs(ca.r - cb.r) + std::abs(ca.g - cb.g) + std::abs(ca.b - cb.b);
+        }
+        return error;
+    }
+
+    // Send only cells that differ from what is on screen, by more than the
+    // detail level's threshold, within `budget` bytes. When not all fit,
+    // the cells with the largest error go first; the rest keep their error
+    // and compete again next frame. The detail level rises while cells are
+    // deferred, which coarsens colors so neighbouring cells share escapes,
+    // and falls again once frames fit comfortably.
+    void encode_budgeted(const Framebuffer& fb, int out_width, int out_height, size_t budget,
+                         std::string& output) {
+        output.clear();
+        int cell_cols, cell_rows, columns, rows;
+        cell_pixels(backend, cell_cols, cell_rows);
+        build_cells(fb, out_width, out_height, cell_cols, cell_rows, DROPPED_BITS[detail_level], columns, rows);
+        if (columns != shown_columns || shown.size() != cells.size()) {
+            shown.assign(cells.size(), TextCell());
+            shown_columns = columns;
+        }
+
+        int pixels = cell_cols * cell_rows;
+        int threshold = SKIP_THRESHOLD[detail_level] * pixels;
+        candidates.clear();
+        for (size_t i = 0; i < cells.size(); i++) {
+            int error = cell_error(cells[i], shown[i], pixels);
+            if (error > threshold) candidates.emplace_back(error, static_cast<int>(i));
+        }
+
+        size_t changed = candidates.size();
+        size_t limit = static_cast<size_t>(budget / cell_cost);
+        if (changed > limit) {
+            std::nth_element(candidates.begin(), candidates.begin() + limit, candidates.end(),
+                             [](const auto& a, const auto& b) { return a.first > b.first; });
+            candidates.resize(limit);
+        }
+        std::sort(candidates.begin(), candidates.end(),
+                  [](const auto& a, const auto& b) { return a.second < b.second; });
+
+        // Colors and cursor position carry over between cells, so runs of
+        // cells only pay for what changes
+        const std::string* glyphs = cell_glyphs(cell_cols, cell_rows);
+        uint32_t fg = UNKNOWN_COLOR, bg = UNKNOWN_COLOR;
+        int next = -1;
+        size_t sent = 0;
+        for (const auto& candidate : candidates) {
+            if (output.size() >= budget) break;     // Cells were cheaper to estimate than to send
+            int i = candidate.second;
+            if (i != next || i % columns == 0) {
+                char move[32];
+                snprintf(move, sizeof(move), "\033[%d;%dH", i / columns + 1, i % columns + 1);
+                output += move;
+            }
+            const TextCell& cell = cells[i];
+            if (cell.bg != bg) append_code(output, bg = cell.bg, true);
+            if (cell.pattern != 0 && cell.fg != fg) append_code(output, fg = cell.fg, false);
+            output += glyphs[cell.pattern];
+            shown[i] = cell;
+            next = i + 1;
+            sent++;
+        }
+        deferred_cells = static_cast<int>(changed - sent);
+        if (sent > 0) {
+            output += "\033[0m";
+            cell_cost = cell_cost * 0.8 + 0.2 * static_cast<double>(output.size()) / sent;
+        }
+
+        if (deferred_cells > static_cast<int>(changed / 20)) {
+            detail_level = std::min(detail_level + 1, DETAIL_LEVELS - 1);
+            calm_frames = 0;
+        } else if (output.size() < budget / 2 && ++calm_frames >= 10) {
+            detail_level = std::max(detail_level - 1, 0);
+            calm_frames = 0;
+        }
+    }
+
+    // Glyphs by pattern for `cell_cols` x `cell_rows` pixels per cell
+    static const std::string* cell_glyphs(int cell_cols, int cell_rows) {
+        if (cell_cols == 1) return half_block_glyphs();
+        return cell_rows == 2 ? quadrant_glyphs() : sextant_glyphs();
+    }
+
+    // --- Text colors ---
+
+    // What the terminal is sent for `c` in the active color mode: packed RGB
+    // with `dropped_bits` low bits rounded away per channel, or a palette
+    // index; (x, y) picks the dither threshold
+    uint32_t color_code(const Color& c, int x, int y, int dropped_bits) const {
+        if (colors == ColorMode::TRUECOLOR) {
+            auto round = [dropped_bits](uint8_t v) -> uint32_t {
+                if (dropped_bits == 0) return v;
+                return std::min(255, (v + (1 << (dropped_bits - 1))) >> dropped_bits << dropped_bits);
+            };
+            return round(c.r) << 16 | round(c.g) << 8 | round(c.b);
+        }
+        const PaletteLUT& lut = PaletteLUT::get(colors);
+        return dither ? lut.lookup(c, x, y) : lut.lookup(c);
+    }
+
+    // Color the terminal shows for a color_code()
+    Color code_color(uint32_t code) const {
+        if (colors == ColorMode::TRUECOLOR) {
+            return Color(static_cast<uint8_t>(code >> 16), static_cast<uint8_t>(code >> 8), static_cast<uint8_t>(code));
+        }
+        return palette_color(static_cast<int>(code));
+    }
+
+    // Append the escape selecting a color_code() as foreground or background
+    void append_code(std::string& output, uint32_t code, bool background) const {
+        char buf[32];
+        if (colors == ColorMode::TRUECOLOR) {
+            snprintf(buf, sizeof(buf), "\033[%d;2;%d;%d;%dm", background ? 48 : 38, static_cast<int>(code >> 16),
+                     static_cast<int>((code >> 8) & 255), static_cast<int>(code & 255));
+        } else if (colors == ColorMode::XTERM256) {
+            snprintf(buf, sizeof(buf), "\033[%d;5;%dm", background ? 48 : 38, static_cast<int>(code));
+        } else {
+            // 30-37 / 40-47, bright colors 90-97 / 100-107
+            int index = static_cast<int>(code);
+            snprintf(buf, sizeof(buf), "\033[%dm", (background ? 40 : 30) + (index < 8 ? index : index + 52));
+        }
+        output += buf;
+    }
+
+    void append_color(std::string& output, const Color& c, bool background, int x, int y) const {
+        append_code(output, color_code(c, x, y, 0), background);
+    }
+
+    // --- Mosaic glyphs ---
+
+    // Half blocks by pattern (bits: top, bottom)
+    static const std::string* half_block_glyphs() {
+        static const std::string glyphs[4] = {" ", "\xE2\x96\x80", "\xE2\x96\x84", "\xE2\x96\x88"};
+        return glyphs;
+    }
+
+    // Quadrant characters by pattern (bits: top-left, top-right, bottom-left, bottom-right)
+    static const std::string* quadrant_glyphs() {
+        static const std::vector<std::string> glyphs = [] {
+            const uint32_t codepoints[16] = {
+                ' ', 0x2598, 0x259D, 0x2580, 0x2596, 0x258C, 0x259E, 0x259B,
+                0x2597, 0x259A, 0x2590, 0x259C, 0x2584, 0x2599, 0x259F, 0x2588,
+            };
+            std::vector<std::string> g(16);
+            for (int p = 0; p < 16; p++) append_utf8(g[p], codepoints[p]);
+            return g;
+        }();
+        return glyphs.data();
+    }
+
+    // Sextant characters by pattern (bits in reading order, two per row).
+    // U+1FB00 onwards lists all patterns except blank, full and the two half
+    // blocks, which already exist as U+258C and U+2590.
+    static const std::string* sextant_glyphs() {
+        static const std::vector<std::string> glyphs = [] {
+            std::vector<std::string> g(64);
+            for (int p = 0; p < 64; p++) {
+                if (p == 0) g[p] = " ";
+                else if (p == 63) append_utf8(g[p], 0x2588);
+                else if (p == 21) append_utf8(g[p], 0x258C);
+                else if (p == 42) append_utf8(g[p], 0x2590);
+                else append_utf8(g[p], 0x1FB00 + p - 1 - (p > 21) - (p > 42));
+            }
+            return g;
+        }();
+        return glyphs.data();
+    }
+
+    // --- Sixel ---
+
+    // Index into the 6x6x6 color cube
+    static int sixel_color(const Color& c) {
+        auto level = [](uint8_t v) { return (v * 5 + 127) / 255; };
+        return level(c.r) * 36 + level(c.g) * 6 + level(c.b);
+    }
+
+    // Append `count` repetitions of sixel character `ch`, run-length encoded
+    static void append_sixel_run(std::string& output, char ch, int count) {
+        if (count > 3) {
+            output += '!';
+            output += std::to_string(count);
+            output += ch;
+        } else {
+            output.append(count, ch);
+        }
+    }
+
+    void encode_sixel(const Framebuffer& fb, int out_width, int out_height, std::string& output) {
+        int width = out_width * cell_width;
+        int height = (out_height / 2) * cell_height;
+        if (width <= 0 || height <= 0) return;
+
+        // Nearest-neighbour upscaling repeats each framebuffer column over a
+        // span of screen columns, which run-length encoding absorbs
+        spans.assign(fb.width, 0);
+        for (int x = 0; x < width; x++) spans[static_cast<int64_t>(x) * fb.width / width]++;
+
+        output += "\033[H\033P0;1;0q";    // Unpainted pixels stay transparent
+        output += "\"1;1;" + std::to_string(width) + ";" + std::to_string(height);
+
+        bool defined[216] = {};
+        masks.resize(216 * fb.width);
+        row_colors.resize(fb.width);
+        for (int y0 = 0; y0 < height; y0 += 6) {
+            int rows = std::min(6, height - y0);
+
+            // Sixel bits of every color present in the band, per column
+            bool used[216] = {};
+            int prev_src_y = -1;
+            for (int r = 0; r < rows; r++) {
+                int src_y = static_cast<int>(static_cast<int64_t>(y0 + r) * fb.height / height);
+                if (src_y != prev_src_y) {
+                    for (int x = 0; x < fb.width; x++) row_colors[x] = sixel_color(fb.get_pixel(x, src_y));
+                    prev_src_y = src_y;
+                }
+                for (int x = 0; x < fb.width; x++) {
+                    int color = row_colors[x];
+                    if (!used[color]) {
+                        used[color] = true;
+                        std::fill_n(&masks[color * fb.width], fb.width, 0);
+                    }
+                    masks[color * fb.width + x] |= 1 << r;
+                }
+            }
+
+            // One line per color present in the band, overprinting the same six rows
+            bool first = true;
+            for (int color = 0; color < 216; color++) {
+                if (!used[color]) continue;
+                if (!first) output += '$';
+                first = false;
+                output += '#';
+                output += std::to_string(color);
+                if (!defined[color]) {
+                    defined[color] = true;
+                    char def[32];
+                    snprintf(def, sizeof(def), ";2;%d;%d;%d", color / 36 * 20, color / 6 % 6 * 20, color % 6 * 20);
+                    output += def;
+                }
+
+                const uint8_t* mask = &masks[color * fb.width];
+                char run_char = 0;
+                int run = 0;
+                for (int x = 0; x < fb.width; x++) {
+                    char ch = static_cast<char>('?' + mask[x]);
+                    if (ch != run_char && run > 0) {
+                        append_sixel_run(output, run_char, run);
+                        run = 0;
+                    }
+                    run_char = ch;
+                    run += spans[x];
+                }
+                if (run_char != '?') append_sixel_run(output, run_char, run);  // Trailing blanks are implied
+            }
+            output += '-';
+        }
+        output += "\033\\";
+    }
+
+    // --- Kitty ---
+
+#ifndef _WIN32
+    std::string shm_name(int slot) const {
+        return "/clirasterizer-" + std::to_string(getpid()) + "-" + std::to_string(slot);
+    }
+
+    // Publish `size` bytes as a shared memory object the terminal reads and unlinks
+    static bool write_shm(const std::string& name, const uint8_t* data, size_t size) {
+        shm_unlink(name.c_str());   // Left over if the terminal never read it
+        int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+        if (fd < 0) return false;
+        bool ok = ftruncate(fd, static_cast<off_t>(size)) == 0;
+        if (ok) {
+            void* map = mmap(nullptr, size, PROT_WRITE, MAP_SHARED, fd, 0);
+            ok = map != MAP_FAILED;
+            if (ok) {
+                memcpy(map, data, size);
+                munmap(map, size);
+            }
+        }
+        close(fd);
+        if (!ok) shm_unlink(name.c_str());
+        return ok;
+    }
+#endif
+
+    void encode_kitty(const Framebuffer& fb, int out_width, int out_height, std::string& output) {
+        fb.copy_rgb(pixels);
+
+        // Transmit and place in one command; reusing the image and placement
+        // ids replaces the previous frame without flicker
+        char keys[160];
+        snprintf(keys, sizeof(keys), "a=T,f=24,s=%d,v=%d,c=%d,r=%d,i=%d,p=1,C=1,q=2",
+                 fb.width, fb.height, out_width, out_height / 2, KITTY_IMAGE_ID);
+        output += "\033[H";
+
+#ifndef _WIN32
+        if (kitty_transfer == KittyTransfer::SHM) {
+            std::string name = shm_name(shm_serial++ % SHM_SLOTS);
+            if (write_shm(name, pixels.data(), pixels.size())) {
+                output += "\033_G";
+                output += keys;
+                output += ",t=s,S=" + std::to_string(pixels.size()) + ";";
+                append_base64(output, reinterpret_cast<const uint8_t*>(name.data()), name.size());
+                output += "\033\\";
+                return;
+            }
+            kitty_transfer = KittyTransfer::ZLIB;   // No shared memory here, stop trying
+        }
+#endif
+
+        int compressed_size = 0;
+        unsigned char* compressed = stbi_zlib_compress(pixels.data(), static_cast<int>(pixels.size()),
+                                                       &compressed_size, 5);
+        payload.clear();
+        if (compressed) {
+            append_base64(payload, compressed, compressed_size);
+            free(compressed);
+        } else {
+            append_base64(payload, pixels.data(), pixels.size());
+        }
+
+        // The payload is sent in chunks of at most 4096 base64 characters
+        constexpr size_t CHUNK = 4096;
+        for (size_t off = 0; off == 0 || off < payload.size(); off += CHUNK) {
+            bool more = off + CHUNK < payload.size();
+            output += "\033_G";
+            if (off == 0) {
+                output += keys;
+                if (compressed) output += ",o=z";
+                output += ",";
+            }
+            output += more ? "m=1;" : "m=0;";
+            output.append(payload, off, CHUNK);
+            output += "\033\\";
+        }
+    }
+};
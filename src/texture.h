@@ -0,0 +1,108 @@
+#pragma once
+
+#include <iostream>
+#include <memory>
+#include <span>
+#include <vector>
+#include <cmath>
+#include <algorithm>
+#include <cstdint>
+
+#include "stb_image.h"
+#include "color.h"
+
+// ============================================================================
+// Texture - loads and samples image textures (with alpha channel support)
+// ============================================================================
+//
+// `data` is an RGBA8 view into the texture's own storage or into a mapped
+// scene cache, like Mesh::vertices.
+
+class Texture {
+public:
+    int width = 0, height = 0, channels = 0;
+    std::span<const uint8_t> data;
+    bool loaded = false;
+    bool has_alpha = false;
+
+    Texture() = default;
+    Texture(Texture&&) = default;
+    Texture& operator=(Texture&&) = default;
+    Texture(const Texture&) = delete;
+    Texture& operator=(const Texture&) = delete;
+
+    // Take ownership of `w` x `h` RGBA8 pixels
+    void set_pixels(int w, int h, std::vector<uint8_t> rgba, bool alpha) {
+        storage = std::move(rgba);
+        backing.reset();
+        set_fields(w, h, storage, alpha);
+    }
+
+    // Reference RGBA8 pixels owned by `owner` without copying
+    void set_view(int w, int h, std::span<const uint8_t> rgba, bool alpha, std::shared_ptr<const void> owner) {
+        storage.clear();
+        storage.shrink_to_fit();
+        backing = std::move(owner);
+        set_fields(w, h, rgba, alpha);
+    }
+    
+    bool load(const char* filename, bool verbose = true) {
+        // Load with 4 channels (RGBA) to support alpha
+        int w, h, file_channels;
+        uint8_t* img_data = stbi_load(filename, &w, &h, &file_channels, 4);
+        return take_image(img_data, w, h, file_channels, filename, verbose);
+    }
+    
+    // Decode an image file held in memory (e.g. embedded in a glTF buffer)
+    bool load_from_memory(const uint8_t* bytes, size_t size, const char* name, bool verbose = true) {
+        int w, h, file_channels;
+        uint8_t* img_data = stbi_load_from_memory(bytes, static_cast<int>(size), &w, &h, &file_channels, 4);
+        return take_image(img_data, w, h, file_channels, name, verbose);
+    }
+    
+    Color sample(float u, float v) const {
+        if (!loaded) return Color(200, 200, 200, 255);
+        
+        // Wrap UV coordinates
+        u = u - std::floor(u);
+        v = v - std::floor(v);
+        
+        int x = static_cast<int>(u * (width - 1));
+        int y = static_cast<int>((1.0f - v) * (height - 1));  // Flip V
+        
+        x = std::clamp(x, 0, width - 1);
+        y = std::clamp(y, 0, height - 1);
+        
+        int idx = (y * width + x) * 4;
+        return Color(data[idx], data[idx + 1], data[idx + 2], data[idx + 3]);
+    }
+
+private:
+    std::vector<uint8_t> storage;
+    std::shared_ptr<const void> backing;
+
+    bool take_image(uint8_t* img_data, int w, int h, int file_channels, const char* name, bool verbose) {
+        if (!img_data) {
+            std::cerr << "Failed to load texture: " << name << std::endl;
+            return false;
+        }
+        set_pixels(w, h, std::vector<uint8_t>(img_data, img_data + static_cast<size_t>(w) * h * 4),
+                   file_channels == 4);
+        channels = file_channels;
+        stbi_image_free(img_data);
+        if (verbose) {
+            std::cout << "Loaded texture: " << width << "x" << height
+                      << " (alpha: " << (has_alpha ? "yes" : "no") << ")" << std::endl;
+        }
+        return true;
+    }
+
+    void set_fields(int w, int h, std::span<const uint8_t> rgba, bool alpha) {
+        width = w;
+        height = h;
+        channels = 4;
+        data = rgba;
+        has_alpha = alpha;
+        loaded = true;
+    }
+};
@@ -0,0 +1,141 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+// ============================================================================
+// Trace - scoped timing events exported as Chrome trace-event JSON
+// ============================================================================
+//
+// Every thread records into its own lane, a fixed-size ring buffer holding
+// the most recent events, so recording never locks and memory stays
+// bounded. Lane 0 is the main thread, lanes 1..N are parallel_for workers
+// (one per chunk), higher lanes belong to long-lived helper threads.
+// The JSON opens in chrome://tracing and ui.perfetto.dev.
+
+struct TraceEvent {
+    const char* name;   // Must have static storage duration
+    int64_t start_ns;   // Relative to the tracer epoch
+    int64_t duration_ns;
+};
+
+class Tracer {
+public:
+    static constexpr int MAX_LANES = 256;
+    static constexpr size_t EVENTS_PER_LANE = 8192;
+
+    static Tracer& instance() {
+        static Tracer tracer;
+        return tracer;
+    }
+
+    int64_t now_ns() const {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    // Append an event to `lane`; only the thread owning the lane may call this
+    void record(int lane, const char* name, int64_t start_ns, int64_t end_ns) {
+        if (lane < 0 || lane >= MAX_LANES) return;
+        Lane& l = get_lane(lane);
+        l.events[l.written % EVENTS_PER_LANE] = {name, start_ns, end_ns - start_ns};
+        l.written++;
+    }
+
+    void set_lane_name(int lane, const char* name) {
+        if (lane < 0 || lane >= MAX_LANES) return;
+        Lane& l = get_lane(lane);
+        if (l.name != name) l.name = name;
+    }
+
+    // Write all buffered events. Call while no worker is recording
+    // (between frames), since the rings are read without synchronization.
+    bool write_json(const char* filename) const {
+        FILE* f = fopen(filename, "w");
+        if (!f) return false;
+
+        fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+        bool first = true;
+        for (int lane = 0; lane < MAX_LANES; lane++) {
+            const Lane* l = lanes[lane].get();
+            if (!l) continue;
+
+            fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+                    first ? "" : ",\n", lane, l->name.c_str());
+            fprintf(f, ",\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"sort_index\":%d}}",
+                    lane, lane);
+            first = false;
+
+            uint64_t count = std::min<uint64_t>(l->written, EVENTS_PER_LANE);
+            for (uint64_t i = l->written - count; i < l->written; i++) {
+                const TraceEvent& e = l->events[i % EVENTS_PER_LANE];
+                fprintf(f, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                        e.name, lane, e.start_ns / 1000.0, e.duration_ns / 1000.0);
+            }
+        }
+        fprintf(f, "\n]}\n");
+        return fclose(f) == 0;
+    }
+
+private:
+    struct Lane {
+        std::string name;
+        std::vector<TraceEvent> events;
+        uint64_t written = 0;
+    };
+
+    Tracer() : epoch(std::chrono::steady_clock::now()) {}
+
+    // Lanes are created on first use by their owning thread
+    Lane& get_lane(int lane) {
+        if (!lanes[lane]) {
+            auto l = std::make_unique<Lane>();
+            l->events.resize(EVENTS_PER_LANE);
+            l->name = (lane == 0) ? "main" : "worker " + std::to_string(lane - 1);
+            lanes[lane] = std::move(l);
+        }
+        return *lanes[lane];
+    }
+
+    std::chrono::steady_clock::time_point epoch;
+    std::array<std::unique_ptr<Lane>, MAX_LANES> lanes;
+};
+
+// Lane the current thread records into
+inline thread_local int trace_lane = 0;
+
+// Binds the current thread to a lane for the lifetime of the object
+class TraceLane {
+public:
+    explicit TraceLane(int lane, const char* name = nullptr) : previous(trace_lane) {
+        trace_lane = lane;
+        if (name) Tracer::instance().set_lane_name(lane, name);
+    }
+    ~TraceLane() { trace_lane = previous; }
+
+private:
+    int previous;
+};
+
+// Records the enclosing scope as one event on the current thread's lane
+class TraceScope {
+public:
+    explicit TraceScope(const char* name) : name(name), start(Tracer::instance().now_ns()) {}
+    ~TraceScope() {
+        Tracer& tracer = Tracer::instance();
+        tracer.record(trace_lane, name, start, tracer.now_ns());
+    }
+
+private:
+    const char* name;
+    int64_t start;
+};
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+#define TRACE_SCOPE(name) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name)
@@ -0,0 +1,232 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "platform.h"
+#include "stb_image.h"
+
+// Implemented in stb_image_write.h (third_party.cpp); returns a zlib stream
+// to be released with free()
+extern "C" unsigned char* stbi_zlib_compress(unsigned char* data, int data_len, int* out_len, int quality);
+
+// ============================================================================
+// TTY recording - the exact byte stream sent to the terminal, per frame
+// ============================================================================
+//
+// TtyRecorder sits between std::cout and its original stream buffer, so
+// everything the viewer prints (frames, status lines, escape sequences) is
+// passed through unchanged and also collected. end_frame() closes a frame;
+// a background thread compresses it and appends it to the file.
+//
+// File layout (little-endian):
+//   "CLIRTTY1"
+//   per frame: u64 microseconds since the recording started,
+//              u32 frame size, u32 stored size, stored bytes
+// A frame is zlib-compressed when that is smaller, otherwise stored as is
+// (stored size == frame size). A file cut short by a crash ends at the last
+// complete frame.
+//
+// replay_tty_recording() writes a recording back to stdout at the recorded
+// pace or as fast as the terminal accepts it, and reports the throughput.
+
+constexpr char TTY_RECORDING_MAGIC[8] = {'C', 'L', 'I', 'R', 'T', 'T', 'Y', '1'};
+
+class TtyRecorder : public std::streambuf {
+public:
+    TtyRecorder() = default;
+    TtyRecorder(const TtyRecorder&) = delete;
+    TtyRecorder& operator=(const TtyRecorder&) = delete;
+    ~TtyRecorder() override { close(); }
+
+    // Start recording everything written to std::cout into `path`
+    bool open(const char* path) {
+        file = fopen(path, "wb");
+        if (!file) {
+            std::cerr << "Failed to open recording: " << path << std::endl;
+            return false;
+        }
+        fwrite(TTY_RECORDING_MAGIC, 1, sizeof(TTY_RECORDING_MAGIC), file);
+        start = std::chrono::steady_clock::now();
+        target = std::cout.rdbuf(this);
+        writer = std::thread([this] { writer_loop(); });
+        return true;
+    }
+
+    bool is_open() const { return file != nullptr; }
+
+    // Everything written since the previous call becomes one frame
+    void end_frame() {
+        if (!file) return;
+        uint64_t timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - start).count();
+        std::unique_lock<std::mutex> lock(mutex);
+        // Recording has to be exact, so a slow disk slows the viewer down
+        space_available.wait(lock, [this] { return queue.size() < MAX_QUEUED; });
+        queue.push_back({timestamp, std::move(pending)});
+        pending.clear();
+        work_available.notify_one();
+    }
+
+    // Write the last frame, wait for the file and give std::cout back
+    void close() {
+        if (!file) return;
+        std::cout.flush();
+        if (!pending.empty()) end_frame();
+        std::cout.rdbuf(target);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            done = true;
+        }
+        work_available.notify_all();
+        writer.join();
+        fclose(file);
+        file = nullptr;
+    }
+
+protected:
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+        pending.append(s, static_cast<size_t>(n));
+        return target->sputn(s, n);
+    }
+
+    int_type overflow(int_type ch) override {
+        if (traits_type::eq_int_type(ch, traits_type::eof())) return traits_type::not_eof(ch);
+        pending += traits_type::to_char_type(ch);
+        return target->sputc(traits_type::to_char_type(ch));
+    }
+
+    int sync() override { return target->pubsync(); }
+
+private:
+    struct Frame {
+        uint64_t timestamp;
+        std::string bytes;
+    };
+
+    static constexpr size_t MAX_QUEUED = 8;
+
+    FILE* file = nullptr;
+    std::streambuf* target = nullptr;
+    std::string pending;
+    std::chrono::steady_clock::time_point start;
+    std::thread writer;
+    std::deque<Frame> queue;
+    std::mutex mutex;
+    std::condition_variable work_available;
+    std::condition_variable space_available;
+    bool done = false;
+
+    static void put_u32(std::string& out, uint32_t v) {
+        for (int i = 0; i < 4; i++) out += static_cast<char>(v >> (8 * i));
+    }
+
+    void writer_loop() {
+        std::string header;
+        while (true) {
+            Frame frame;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                work_available.wait(lock, [this] { return done || !queue.empty(); });
+                if (queue.empty()) return;
+                frame = std::move(queue.front());
+                queue.pop_front();
+            }
+            space_available.notify_one();
+
+            int compressed_size = 0;
+            unsigned char* compressed = stbi_zlib_compress(reinterpret_cast<unsigned char*>(frame.bytes.data()),
+                                                           static_cast<int>(frame.bytes.size()), &compressed_size, 5);
+            bool use_compressed = compressed && static_cast<size_t>(compressed_size) < frame.bytes.size();
+            const char* data = use_compressed ? reinterpret_cast<const char*>(compressed) : frame.bytes.data();
+            size_t size = use_compressed ? static_cast<size_t>(compressed_size) : frame.bytes.size();
+
+            header.clear();
+            put_u32(header, static_cast<uint32_t>(frame.timestamp));
+            put_u32(header, static_cast<uint32_t>(frame.timestamp >> 32));
+            put_u32(header, static_cast<uint32_t>(frame.bytes.size()));
+            put_u32(header, static_cast<uint32_t>(size));
+            fwrite(header.data(), 1, header.size(), file);
+            fwrite(data, 1, size, file);
+            fflush(file);   // Keep the file complete up to this frame if the viewer is killed
+            free(compressed);
+        }
+    }
+};
+
+// Write a recording to stdout. `speed` scales the recorded pace (1 is real
+// time); 0 writes frames back to back, which measures the terminal itself.
+inline int replay_tty_recording(const char* path, double speed) {
+    FILE* f = fopen(path, "rb");
+    char magic[sizeof(TTY_RECORDING_MAGIC)];
+    if (!f || fread(magic, 1, sizeof(magic), f) != sizeof(magic) ||
+        memcmp(magic, TTY_RECORDING_MAGIC, sizeof(magic)) != 0) {
+        std::cerr << "Not a terminal recording: " << path << std::endl;
+        if (f) fclose(f);
+        return 1;
+    }
+
+    enable_raw_input();     // Keystrokes are not echoed into the replay; Ctrl+C restores the terminal
+    std::vector<char> stored, bytes;
+    int frames = 0;
+    uint64_t total_bytes = 0, last_timestamp = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (true) {
+        unsigned char header[16];
+        if (fread(header, 1, sizeof(header), f) != sizeof(header)) break;
+        auto u32 = [&](int offset) {
+            return static_cast<uint32_t>(header[offset]) | static_cast<uint32_t>(header[offset + 1]) << 8 |
+                   static_cast<uint32_t>(header[offset + 2]) << 16 | static_cast<uint32_t>(header[offset + 3]) << 24;
+        };
+        uint64_t timestamp = u32(0) | static_cast<uint64_t>(u32(4)) << 32;
+        uint32_t size = u32(8), stored_size = u32(12);
+        stored.resize(stored_size);
+        if (fread(stored.data(), 1, stored_size, f) != stored_size) break;
+
+        const char* data = stored.data();
+        if (stored_size != size) {
+            bytes.resize(size);
+            if (stbi_zlib_decode_buffer(bytes.data(), static_cast<int>(size), stored.data(),
+                                        static_cast<int>(stored_size)) != static_cast<int>(size)) {
+                std::cerr << "Corrupt frame " << frames << " in " << path << std::endl;
+                break;
+            }
+            data = bytes.data();
+        }
+
+        if (speed > 0) {
+            std::this_thread::sleep_until(start + std::chrono::microseconds(static_cast<int64_t>(timestamp / speed)));
+        }
+        fwrite(data, 1, size, stdout);
+        fflush(stdout);
+        frames++;
+        total_bytes += size;
+        last_timestamp = timestamp;
+    }
+    fclose(f);
+#ifndef _WIN32
+    tcdrain(STDOUT_FILENO);     // Count the time until the terminal took everything
+#endif
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::string replies;
+    read_input(replies);    // Drop terminal replies to recorded queries
+    restore_terminal();
+    std::cout << "\033[?25h\033[0m" << std::flush;
+
+    std::cerr << "Replayed " << frames << " frames, " << total_bytes << " bytes in " << std::fixed
+              << std::setprecision(2) << seconds << "s (recorded " << last_timestamp / 1e6 << "s): "
+              << frames / std::max(seconds, 1e-6) << " frames/s, " << total_bytes / std::max(seconds, 1e-6) / 1e6
+              << " MB/s" << std::endl;
+    return 0;
+}